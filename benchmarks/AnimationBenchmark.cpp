@@ -0,0 +1,131 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "Animation.hpp"
+#include "AnimationSystem.hpp"
+#include "SpriteBatch.hpp"
+#include "Texture.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+
+using Clock = std::chrono::steady_clock;
+
+// Nanoseconds per sprite of a pass over all of them, GL work included
+template <typename Function>
+double Measure(std::size_t sprite_count, int passes, Function&& pass)
+{
+	glFinish();
+	const auto start = Clock::now();
+
+	for (int i = 0; i < passes; ++i)
+		pass();
+
+	glFinish();
+	const std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+
+	return elapsed.count() / (double(sprite_count) * passes);
+}
+
+// Animation update throughput: AnimationBenchmark [sprite count] [passes]
+int main(int argc, char* argv[])
+{
+	const std::size_t sprite_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+	const int         passes       = argc > 2 ? std::atoi(argv[2]) : 100;
+
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+	GLFWwindow* window = glfwCreateWindow(64, 64, "Animation benchmark", NULL, NULL);
+
+	if (window == NULL)
+	{
+		std::cout << "Failed to create GLFW window\n";
+		glfwTerminate();
+		return -1;
+	}
+	glfwMakeContextCurrent(window);
+
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		return -1;
+	}
+
+	{
+		Texture texture;
+		texture.create(128, 384, 4);
+
+		AnimationLibrary library;
+		const ClipId clips[]
+		{
+			library.add("walk down",  0, 192, 32, 48, 3, 0.5f, true),
+			library.add("walk left",  0, 240, 32, 48, 3, 0.5f, true),
+			library.add("walk right", 0, 288, 32, 48, 3, 0.5f, true),
+			library.add("walk up",    0, 336, 32, 48, 3, 0.5f, true)
+		};
+		const char* names[] { "walk down", "walk left", "walk right", "walk up" };
+
+		// Sprites own GL buffers and can't be moved, a deque never moves them
+		std::deque<AnimationManager> sprites;
+
+		for (std::size_t i = 0; i < sprite_count; ++i)
+		{
+			AnimationManager& sprite = sprites.emplace_back(library);
+			sprite.setTexture(&texture);
+			sprite.set(clips[i % 4]);
+			sprite.play();
+		}
+
+		// 0.0625 s steps over a 0.5 s delay: every sprite changes its frame on every 8th pass
+		const double tick_time = Measure(sprite_count, passes, [&]
+		{
+			for (auto& sprite : sprites)
+				sprite.tick(0.0625f);
+		});
+
+		// The same clip again is the common case in a game loop: input keeps selecting the current walk cycle
+		const double set_by_id = Measure(sprite_count, passes, [&]
+		{
+			std::size_t i = 0;
+			for (auto& sprite : sprites)
+				sprite.set(clips[i++ % 4]);
+		});
+
+		const double set_by_name = Measure(sprite_count, passes, [&]
+		{
+			std::size_t i = 0;
+			for (auto& sprite : sprites)
+				sprite.set(names[i++ % 4]);
+		});
+
+		// The same animations through AnimationSystem: one pass over the states, one upload for the batch
+		SpriteBatch     batch(&texture);
+		AnimationSystem system(library);
+
+		for (std::size_t i = 0; i < sprite_count; ++i)
+			system.add(batch, batch.add(glm::vec2(0.0f), glm::fRect()), clips[i % 4]);
+
+		batch.upload();
+
+		const double batched_time = Measure(sprite_count, passes, [&]
+		{
+			system.update(0.0625f);
+			batch.upload();
+		});
+
+		std::cout << sprite_count << " sprites, " << passes << " passes\n"
+		          << "tick:        " << tick_time   << " ns per sprite\n"
+		          << "set by id:   " << set_by_id   << " ns per sprite\n"
+		          << "set by name: " << set_by_name << " ns per sprite\n"
+		          << "batched:     " << batched_time << " ns per sprite\n";
+	}
+
+	glfwTerminate();
+	return 0;
+}
@@ -0,0 +1,222 @@
+#include "Animation.hpp"
+#include "Camera.hpp"
+#include "NullGL.hpp"
+#include "ShaderProgram.hpp"
+#include "Sprite.hpp"
+#include "Texture.hpp"
+#include "TileMap.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using Clock = std::chrono::steady_clock;
+
+// Milliseconds spent in one phase, summed over all frames
+struct Phase
+{
+	const char* name;
+	double      total = 0.0;
+
+	template <typename Function>
+	void measure(Function&& function)
+	{
+		const auto start = Clock::now();
+		function();
+		total += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+};
+
+// Square map with two layers of tiles from a 32 x 32 tileset, ids from a fixed LCG so every run loads the same map
+bool WriteMap(const std::string& path, unsigned size)
+{
+	std::ofstream file(path);
+
+	if (!file.is_open())
+		return false;
+
+	file << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+	     << "<map width=\"" << size << "\" height=\"" << size << "\" tilewidth=\"32\" tileheight=\"32\">\n";
+
+	std::uint32_t seed = 1;
+
+	for (int layer = 0; layer < 2; ++layer)
+	{
+		file << " <layer width=\"" << size << "\" height=\"" << size << "\">\n  <data encoding=\"csv\">\n";
+
+		for (unsigned i = 0; i < size * size; ++i)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			// The upper layer is mostly empty, like decorations over the ground
+			const unsigned tile = layer == 0 || seed % 4 == 0 ? 1 + (seed >> 8) % 1024 : 0;
+			file << tile << (i + 1 < size * size ? "," : "\n");
+		}
+
+		file << "  </data>\n </layer>\n";
+	}
+
+	file << "</map>\n";
+
+	return file.good();
+}
+
+// CPU cost of the engine's own code with GL calls stubbed out (see NullGL):
+// CpuBenchmark [map size in tiles] [sprite count] [frames]. Run it from bin, the shaders are read from res
+int main(int argc, char* argv[])
+{
+	const unsigned    map_size     = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 256;
+	const std::size_t sprite_count = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10000;
+	const unsigned    frame_count  = argc > 3 ? std::max(1ul, std::strtoul(argv[3], nullptr, 10)) : 300;
+
+	if (!NullGL::load())
+	{
+		std::cout << "Failed to load NullGL\n";
+		return -1;
+	}
+
+	const std::string map_path = (std::filesystem::temp_directory_path() / "CpuBenchmark.tmx").string();
+
+	if (!WriteMap(map_path, map_size))
+	{
+		std::cout << "Failed to write " << map_path << '\n';
+		return -1;
+	}
+
+	glm::ivec2 screen_size(1200, 800);
+
+	Texture tileset;
+	tileset.create(1024, 1024, 4);
+
+	Texture characters;
+	characters.create(128, 384, 4);
+
+	TileMap level(&screen_size);
+	Phase   map_load { "TileMap::load" };
+	bool    is_loaded = false;
+
+	map_load.measure([&] { is_loaded = level.load(map_path.c_str(), &tileset); });
+	std::filesystem::remove(map_path);
+
+	if (!is_loaded)
+		return -1;
+
+	Camera camera;
+	camera.setViewport(screen_size);
+
+	ShaderProgram tilemap_shader;
+	ShaderProgram sprite_shader;
+	Phase         shader_link { "ShaderProgram::link" };
+
+	shader_link.measure([&]
+	{
+		tilemap_shader.compile("res/shaders/tilemap_shader.vert", GL_VERTEX_SHADER);
+		tilemap_shader.compile("res/shaders/tilemap_shader.frag", GL_FRAGMENT_SHADER);
+		tilemap_shader.link();
+
+		sprite_shader.compile("res/shaders/sprite_shader.vert", GL_VERTEX_SHADER);
+		sprite_shader.compile("res/shaders/sprite_shader.frag", GL_FRAGMENT_SHADER);
+		sprite_shader.link();
+	});
+
+	AnimationLibrary library;
+	const ClipId clips[]
+	{
+		library.add("walk down",  0, 192, 32, 48, 3, 0.1f, true),
+		library.add("walk left",  0, 240, 32, 48, 3, 0.1f, true),
+		library.add("walk right", 0, 288, 32, 48, 3, 0.1f, true),
+		library.add("walk up",    0, 336, 32, 48, 3, 0.1f, true)
+	};
+
+	// Sprites own GL buffers and can't be moved, a deque never moves them
+	std::deque<AnimationManager> sprites;
+
+	for (std::size_t i = 0; i < sprite_count; ++i)
+	{
+		AnimationManager& sprite = sprites.emplace_back(library);
+		sprite.setTexture(&characters);
+		sprite.set(clips[i % 4]);
+		sprite.play();
+		sprite.setPosition(float(i * 37 % 4096), float(i * 53 % 4096));
+	}
+
+	constexpr UniformName MODEL("model");
+	const Uniform<glm::mat4> model = sprite_shader.getUniform<glm::mat4>(MODEL);
+
+	Phase animation { "AnimationManager" };
+	Phase sprite    { "Sprite" };
+	Phase tile_map  { "TileMap" };
+	Phase uniforms  { "ShaderProgram" };
+
+	const float step = 1.0f / 60.0f;
+
+	NullGL::reset();
+	NullGL::setRecording(true);
+
+	for (unsigned frame = 0; frame < frame_count; ++frame)
+	{
+		// Every sprite turns once a second, the rest of the time the same clip is set again
+		animation.measure([&]
+		{
+			std::size_t i = 0;
+			for (auto& manager : sprites)
+			{
+				manager.set(clips[(i++ + frame / 60) % 4]);
+				manager.tick(step);
+			}
+		});
+
+		sprite.measure([&]
+		{
+			for (auto& manager : sprites)
+			{
+				manager.move(1.0f, 0.0f);
+				manager.render(&sprite_shader);
+			}
+		});
+
+		tile_map.measure([&]
+		{
+			level.setViewport(glm::vec2(frame * 4.0f, frame * 2.0f));
+			level.render(&tilemap_shader);
+		});
+
+		// The uniform path alone: one handle and one name lookup per sprite
+		uniforms.measure([&]
+		{
+			sprite_shader.use();
+
+			for (std::size_t i = 0; i < sprite_count; ++i)
+			{
+				sprite_shader.setUniform(model, glm::mat4(1.0f));
+				sprite_shader.setUniform("palette_row", float(i));
+			}
+		});
+	}
+
+	NullGL::setRecording(false);
+
+	std::cout << map_size << " x " << map_size << " tiles, " << sprite_count << " sprites, " << frame_count << " frames\n"
+	          << "setup:\n"
+	          << "  " << map_load.name    << ": " << map_load.total    << " ms\n"
+	          << "  " << shader_link.name << ": " << shader_link.total << " ms\n"
+	          << "per frame:\n";
+
+	for (const Phase* phase : { &animation, &sprite, &tile_map, &uniforms })
+		std::cout << "  " << phase->name << ": " << phase->total / frame_count << " ms\n";
+
+	std::cout << "gl calls per frame: " << NullGL::getCallCount() / frame_count
+	          << ", bytes per frame: " << NullGL::getUploadedBytes() / frame_count << '\n';
+
+	const std::vector<NullGL::Call> calls = NullGL::getCalls();
+
+	for (std::size_t i = 0; i < std::min<std::size_t>(calls.size(), 10); ++i)
+		std::cout << "  " << calls[i].name << ": " << calls[i].count / frame_count << " calls, "
+		          << calls[i].bytes / frame_count << " bytes\n";
+
+	return 0;
+}
@@ -0,0 +1,49 @@
+#version 460 core
+
+// One instance per sprite (see AnimatedSpriteInstance), the frame follows the camera time
+layout (location = 0) in vec2 position;
+layout (location = 1) in uvec2 clip;   // offset of the first frame in the table, frame count
+layout (location = 2) in vec2 timing;  // delay, start time
+layout (location = 3) in vec4 color;
+
+out vec4 Color;
+out vec2 TexCoord;
+
+layout (std140, binding = 0) uniform Camera
+{
+	mat4 projection;
+	mat4 view;
+	vec2 viewport;
+	float time;
+};
+
+// Every clip's frames as left, top, width, height in pixels (AnimationClipTable)
+layout (std430, binding = 0) readonly buffer Clips
+{
+	vec4 frames[];
+};
+
+uniform sampler2D texture1;
+
+const uint PLAY_ONCE = 0x80000000u;
+
+void main()
+{
+	uint frame_count = clip.y & ~PLAY_ONCE;
+	uint frame = 0u;
+
+	// Same steps as AdvanceAnimation: whole delays since the start, wrapped or held on the last frame
+	if (timing.x > 0.0f)
+	{
+		uint steps = uint(max(time - timing.y, 0.0f) / timing.x);
+		frame = (clip.y & PLAY_ONCE) != 0u ? min(steps, frame_count - 1u) : steps % frame_count;
+	}
+
+	vec4 rect = frames[clip.x + frame];
+	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+	vec2 texture_size = vec2(textureSize(texture1, 0));
+
+	gl_Position = projection * view * vec4(position + corner * rect.zw, 0.0f, 1.0f);
+	TexCoord = (rect.xy + corner * rect.zw) / texture_size;
+	Color = color;
+}
@@ -0,0 +1,27 @@
+#version 460 core
+
+// One instance per sprite (see SpriteInstance), the quad corners come from gl_VertexID
+layout (location = 0) in vec4 bounds;  // position xy, size zw
+layout (location = 1) in vec4 uv_rect; // left, top, right, bottom
+layout (location = 2) in vec4 color;
+
+out vec4 Color;
+out vec2 TexCoord;
+
+layout (std140, binding = 0) uniform Camera
+{
+	mat4 projection;
+	mat4 view;
+	vec2 viewport;
+	float time;
+};
+
+void main()
+{
+	// Triangle strip order: top left, top right, bottom left, bottom right
+	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+
+	gl_Position = projection * view * vec4(bounds.xy + corner * bounds.zw, 0.0f, 1.0f);
+	TexCoord = mix(uv_rect.xy, uv_rect.zw, corner);
+	Color = color;
+}
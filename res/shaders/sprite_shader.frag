@@ -1,13 +1,40 @@
-#version 330 core
+#version 460 core
 
 out vec4 FragColor;
 
+#ifdef TINT
 in vec4 Color;
+#endif
 in vec2 TexCoord;
 
 uniform sampler2D texture1;
 
+#ifdef PALETTE_SWAP
+layout (binding = 1) uniform sampler2D palette;
+uniform float palette_row;
+#endif
+
 void main()
 {
-	FragColor = texture(texture1, TexCoord) * Color;
+	vec4 texel = texture(texture1, TexCoord);
+
+#ifdef PALETTE_SWAP
+	texel.rgb = texture(palette, vec2(texel.r, palette_row)).rgb;
+#endif
+
+#ifdef ALPHA_TEST
+	if (texel.a < 0.5f)
+		discard;
+#endif
+
+#ifdef PREMULTIPLY
+	texel.rgb *= texel.a;
+#endif
+
+#ifdef TINT
+	// Works for straight and premultiplied alpha alike, Sprite premultiplies the tint along with the texture
+	FragColor = texel * Color;
+#else
+	FragColor = texel;
+#endif
 }
@@ -1,18 +1,31 @@
 #version 460 core
 
+// Variants add TINT, PREMULTIPLY, ALPHA_TEST and PALETTE_SWAP defines (see SpriteShaderFeature)
+
 layout (location = 0) in vec2 position;
 layout (location = 1) in vec4 color;
 layout (location = 2) in vec2 tex_coord;
 
+#ifdef TINT
 out vec4 Color;
+#endif
 out vec2 TexCoord;
 
+layout (std140, binding = 0) uniform Camera
+{
+	mat4 projection;
+	mat4 view;
+	vec2 viewport;
+	float time;
+};
+
 uniform mat4 model;
-uniform mat4 projection;
 
 void main()
 {
-	gl_Position = projection * model * vec4(position, 0.0f, 1.0f);
+	gl_Position = projection * view * model * vec4(position, 0.0f, 1.0f);
 	TexCoord = tex_coord;
+#ifdef TINT
 	Color = color;
-}
\ No newline at end of file
+#endif
+}
@@ -5,11 +5,18 @@ layout (location = 1) in vec2 tex_coord;
 
 out vec2 TexCoord;
 
-uniform mat4 view;
-uniform mat4 projection;
+layout (std140, binding = 0) uniform Camera
+{
+	mat4 projection;
+	mat4 view;
+	vec2 viewport;
+	float time;
+};
+
+uniform mat4 model; // Offset of the map
 
 void main()
 {
-	gl_Position = projection * view * vec4(position, 0.0f, 1.0f);
+	gl_Position = projection * view * model * vec4(position, 0.0f, 1.0f);
 	TexCoord = tex_coord;
 }
\ No newline at end of file
@@ -0,0 +1,162 @@
+#include "AnimatedSpriteBatch.hpp"
+#include "GLState.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+AnimationClipTable::AnimationClipTable(const AnimationLibrary& library):
+	library(library),
+	buffer(0),
+	buffer_capacity(0),
+	uploaded(0)
+{
+	if (GLState::hasDirectStateAccess())
+		glCreateBuffers(1, &buffer);
+	else
+		glGenBuffers(1, &buffer);
+}
+
+AnimationClipTable::~AnimationClipTable()
+{
+	glDeleteBuffers(1, &buffer);
+	GLState::onBuffersDeleted(1, &buffer);
+}
+
+std::uint32_t AnimationClipTable::getOffset(ClipId clip)
+{
+	if (clip >= offsets.size())
+		sync();
+
+	return offsets[clip];
+}
+
+void AnimationClipTable::update()
+{
+	sync();
+
+	if (frames.empty())
+		return;
+
+	if (frames.size() > buffer_capacity)
+	{
+		buffer_capacity = std::max(frames.size(), 2 * buffer_capacity);
+
+		if (GLState::hasDirectStateAccess())
+		{
+			glNamedBufferData(buffer, buffer_capacity * sizeof(glm::vec4), nullptr, GL_DYNAMIC_DRAW);
+		}
+		else
+		{
+			GLState::bindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, buffer_capacity * sizeof(glm::vec4), nullptr, GL_DYNAMIC_DRAW);
+		}
+
+		// Storage only, the bytes are counted by the uploadBuffer below
+		GLState::onUpload(0);
+
+		uploaded = 0;
+	}
+
+	if (uploaded < frames.size())
+	{
+		GLState::uploadBuffer(GL_SHADER_STORAGE_BUFFER, buffer, uploaded * sizeof(glm::vec4),
+		                      (frames.size() - uploaded) * sizeof(glm::vec4), frames.data() + uploaded);
+		uploaded = frames.size();
+	}
+
+	GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING, buffer);
+}
+
+const AnimationLibrary& AnimationClipTable::getLibrary() const
+{
+	return library;
+}
+
+void AnimationClipTable::sync()
+{
+	for (ClipId id = static_cast<ClipId>(offsets.size()); id < library.size(); ++id)
+	{
+		offsets.push_back(static_cast<std::uint32_t>(frames.size()));
+
+		for (const auto& frame : library.get(id).frames)
+			frames.emplace_back(frame.left, frame.top, frame.width, frame.height);
+	}
+}
+
+AnimatedSpriteBatch::AnimatedSpriteBatch(Texture* texture, AnimationClipTable& clips):
+	texture(texture),
+	clips(clips),
+	instances({
+		{ 2, GL_FLOAT,        offsetof(AnimatedSpriteInstance, position) },
+		{ 2, GL_UNSIGNED_INT, offsetof(AnimatedSpriteInstance, clip_offset) }, // clip_offset, frame_count
+		{ 2, GL_FLOAT,        offsetof(AnimatedSpriteInstance, delay) },       // delay, start_time
+		{ 4, GL_FLOAT,        offsetof(AnimatedSpriteInstance, color) }
+	})
+{
+}
+
+AnimatedSpriteBatch::InstanceId AnimatedSpriteBatch::add(const glm::vec2& position, ClipId clip, float start_time, const Color& color)
+{
+	const InstanceId id = instances.add();
+
+	setPosition(id, position);
+	setClip(id, clip, start_time);
+	setColor(id, color);
+
+	return id;
+}
+
+void AnimatedSpriteBatch::clear()
+{
+	instances.clear();
+}
+
+void AnimatedSpriteBatch::setPosition(InstanceId id, const glm::vec2& position)
+{
+	instances.edit(id).position = position;
+}
+
+void AnimatedSpriteBatch::setClip(InstanceId id, ClipId clip, float start_time)
+{
+	const AnimationClip& data = clips.getLibrary().get(clip);
+
+	// An empty clip would index outside the table, it draws the first frame of its neighbour at worst
+	AnimatedSpriteInstance& instance = instances.edit(id);
+	instance.clip_offset = clips.getOffset(clip);
+	instance.frame_count = std::max<std::uint32_t>(static_cast<std::uint32_t>(data.frames.size()), 1);
+	instance.delay       = data.delay;
+	instance.start_time  = start_time;
+
+	if (!data.is_looped)
+		instance.frame_count |= AnimatedSpriteInstance::PLAY_ONCE;
+}
+
+void AnimatedSpriteBatch::setColor(InstanceId id, const Color& color)
+{
+	instances.edit(id).color = GetInstanceColor(color);
+}
+
+std::size_t AnimatedSpriteBatch::getInstanceCount() const
+{
+	return instances.size();
+}
+
+Texture* AnimatedSpriteBatch::getTexture() const
+{
+	return texture;
+}
+
+void AnimatedSpriteBatch::upload()
+{
+	instances.upload();
+}
+
+void AnimatedSpriteBatch::submit(RenderQueue& queue, ShaderProgram* shader, std::uint8_t layer)
+{
+	instances.submit(queue, shader, texture, layer);
+}
+
+void AnimatedSpriteBatch::draw(ShaderProgram*)
+{
+	instances.draw();
+}
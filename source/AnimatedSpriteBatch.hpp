@@ -0,0 +1,99 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include "Animation.hpp"
+#include "Texture.hpp"
+#include "Color.hpp"
+#include "ShaderProgram.hpp"
+#include "RenderQueue.hpp"
+#include "InstanceBuffer.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Frames of every clip in a library as one shader storage buffer, read by res/shaders/animated_sprite_batch.vert.
+// Clips are immutable and ids stable, so clips added to the library later are appended and nothing moves
+class AnimationClipTable
+{
+public:
+	// Fixed in the shader by layout (binding = 0)
+	static constexpr GLuint BINDING = 0;
+
+	explicit AnimationClipTable(const AnimationLibrary& library = GetAnimationLibrary());
+	AnimationClipTable(const AnimationClipTable&) = delete;
+	AnimationClipTable& operator = (const AnimationClipTable&) = delete;
+	~AnimationClipTable();
+
+	// Index of the clip's first frame in the table
+	std::uint32_t getOffset(ClipId clip);
+
+	// Uploads frames of new clips and binds the table. Once per frame from the GL thread, before drawing
+	void update();
+
+	const AnimationLibrary& getLibrary() const;
+
+private:
+	void sync();
+
+	const AnimationLibrary&    library;
+	std::vector<glm::vec4>     frames;  // left, top, width, height in pixels
+	std::vector<std::uint32_t> offsets; // Indexed by ClipId
+
+	GLuint      buffer;
+	std::size_t buffer_capacity; // Frames the GL buffer holds
+	std::size_t uploaded;
+};
+
+// Per instance vertex data. The frame is picked by the vertex shader from the camera time
+struct AnimatedSpriteInstance
+{
+	// Set in frame_count for clips that don't loop
+	static constexpr std::uint32_t PLAY_ONCE = 0x80000000u;
+
+	glm::vec2     position;
+	std::uint32_t clip_offset;
+	std::uint32_t frame_count;
+	float         delay;
+	float         start_time; // Camera time the clip started at
+	glm::vec4     color;
+};
+
+// Sprites whose animation runs entirely on the GPU: after add() they cost nothing per frame on the CPU.
+// Frames follow AdvanceAnimation: frame = floor((time - start_time) / delay), wrapped for looped clips
+// and held on the last frame for the rest. Meant for ambient animation that never reacts to the game,
+// clips with no delay stay on their first frame
+class AnimatedSpriteBatch
+{
+public:
+	using InstanceId = InstanceBuffer<AnimatedSpriteInstance>::InstanceId;
+
+	AnimatedSpriteBatch(Texture* texture, AnimationClipTable& clips);
+	AnimatedSpriteBatch(const AnimatedSpriteBatch&) = delete;
+	AnimatedSpriteBatch& operator = (const AnimatedSpriteBatch&) = delete;
+
+	// start_time is on the clock given to Camera::setTime, a spread of start times desynchronizes a crowd
+	InstanceId add(const glm::vec2& position, ClipId clip, float start_time, const Color& color = Color::WHITE);
+	void clear();
+
+	void setPosition(InstanceId id, const glm::vec2& position);
+	void setClip(InstanceId id, ClipId clip, float start_time);
+	void setColor(InstanceId id, const Color& color);
+
+	std::size_t getInstanceCount() const;
+	Texture*    getTexture() const;
+
+	// Sends the instances changed since the last upload. Called by draw, GL thread only
+	void upload();
+
+	void submit(RenderQueue& queue, ShaderProgram* shader, std::uint8_t layer);
+	// Issues the draw call only, the shader and the texture must be bound already
+	void draw(ShaderProgram* shader);
+
+private:
+	Texture*                               texture;
+	AnimationClipTable&                    clips;
+	InstanceBuffer<AnimatedSpriteInstance> instances;
+};
@@ -6,85 +6,223 @@
 #include "Sprite.hpp"
 #include "Rectangle.hpp"
 
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
 #include <string_view>
+#include <tuple>
 #include <vector>
-#include <map>
 
-// Single animation data. For example, character one side stand/walk cycle
-struct AnimationData
+// Immutable frame sequence. For example, character one side stand/walk cycle.
+// Defined once in an AnimationLibrary and shared by every sprite playing it
+struct AnimationClip
+{
+	std::vector<glm::fRect> frames;
+	float                   delay     = 0;
+	bool                    is_looped = false;
+};
+
+using ClipId = std::uint32_t;
+
+constexpr ClipId INVALID_CLIP = ~ClipId(0);
+
+// The only per sprite part of an animation: where in which clip it is
+struct AnimationState
 {
 	// Drops important options by default
-	void reset() 
+	void reset()
 	{
-		current_frame = elapsed_time = 0;
+		frame   = 0;
+		elapsed = 0;
 	}
 
-	bool                is_looped     = false;
-	std::size_t         current_frame = 0;
-	std::size_t         end           = 0;
-	float               delay         = 0;
-	float               elapsed_time  = 0;
-	std::vector<glm::fRect> frames;
+	ClipId        clip    = INVALID_CLIP;
+	std::uint32_t frame   = 0;
+	float         elapsed = 0;
+};
+
+// Moves a playback state on by delta_time, true when the frame changed and GetShownFrame has to be shown again.
+// Time left over from a frame carries into the next, so the frames follow the clip's timing at any frame rate.
+// A clip that doesn't loop ends with frame == frames.size() while its last frame stays on screen
+inline bool AdvanceAnimation(const AnimationClip& clip, AnimationState& state, float delta_time)
+{
+	const auto frame_count = static_cast<std::uint32_t>(clip.frames.size());
+
+	if (state.frame >= frame_count)
+		return false;
+
+	state.elapsed += delta_time;
+
+	if (state.elapsed < clip.delay)
+		return false;
+
+	std::uint32_t steps = 1;
+
+	if (clip.delay > 0)
+	{
+		steps = static_cast<std::uint32_t>(state.elapsed / clip.delay);
+		state.elapsed -= steps * clip.delay;
+	}
+	else
+		state.elapsed = 0;
+
+	const std::uint32_t previous = state.frame;
+
+	if (clip.is_looped)
+		state.frame = (state.frame + steps) % frame_count;
+	else
+		state.frame = std::min(state.frame + steps, frame_count);
+
+	return state.frame != previous;
+}
+
+// Frame to draw for a state, an ended clip keeps its last one. The clip must have frames
+inline const glm::fRect& GetShownFrame(const AnimationClip& clip, const AnimationState& state)
+{
+	return clip.frames[std::min<std::size_t>(state.frame, clip.frames.size() - 1)];
+}
+
+// Storage of clips referenced by small integer ids. Ids stay valid for the lifetime of the library
+class AnimationLibrary
+{
+public:
+	// Frames in a row of equal cells starting at (x, y). Identical strips are stored once
+	ClipId addStrip(GLuint x, GLuint y, GLuint width, GLuint height, GLuint duration, float delay, bool loop)
+	{
+		const auto key = std::make_tuple(x, y, width, height, duration, delay, loop);
+
+		if (auto found = strips.find(key); found != strips.end())
+			return found->second;
+
+		AnimationClip clip;
+		clip.delay     = delay;
+		clip.is_looped = loop;
+		clip.frames.reserve(duration);
+
+		for (std::size_t i = 0; i < duration; ++i)
+			clip.frames.emplace_back(x + i * width, y, width, height);
+
+		const ClipId id = add(std::move(clip));
+		strips.emplace(key, id);
+
+		return id;
+	}
+
+	// Names are global to the library. Defining a name again with the same strip gives its clip,
+	// with other frames it's an error: INVALID_CLIP, two characters can't share "walk left"
+	ClipId add(std::string_view name, GLuint x, GLuint y, GLuint width, GLuint height, GLuint duration, float delay, bool loop)
+	{
+		if (ClipId id = find(name); id != INVALID_CLIP)
+		{
+			auto strip = strips.find(std::make_tuple(x, y, width, height, duration, delay, loop));
+
+			if (strip != strips.end() && strip->second == id)
+				return id;
+
+			std::cout << "Animation clip " << name << " is already defined with other frames\n";
+			return INVALID_CLIP;
+		}
+
+		const ClipId id = addStrip(x, y, width, height, duration, delay, loop);
+		names.emplace(name, id);
+
+		return id;
+	}
+
+	ClipId add(AnimationClip clip)
+	{
+		if (clip.frames.empty())
+		{
+			std::cout << "Animation clip without frames\n";
+			return INVALID_CLIP;
+		}
+
+		clips.push_back(std::move(clip));
+		return static_cast<ClipId>(clips.size() - 1);
+	}
+
+	// INVALID_CLIP for unknown names
+	ClipId find(std::string_view name) const
+	{
+		auto found = names.find(name);
+		return found != names.end() ? found->second : INVALID_CLIP;
+	}
+
+	const AnimationClip& get(ClipId id) const
+	{
+		return clips[id];
+	}
+
+	std::size_t size() const
+	{
+		return clips.size();
+	}
+
+private:
+	std::vector<AnimationClip>                                                  clips;
+	std::map<std::string, ClipId, std::less<>>                                  names;
+	std::map<std::tuple<GLuint, GLuint, GLuint, GLuint, GLuint, float, bool>, ClipId> strips;
 };
 
+// Library used by sprites that are not given one
+inline AnimationLibrary& GetAnimationLibrary()
+{
+	static AnimationLibrary library;
+	return library;
+}
+
 // Sprite with only one linear animation
 class AnimatedSprite: public Sprite
 {
 public:
 	AnimatedSprite(Texture* texture, GLuint x, GLuint y, GLuint width, GLuint height, GLuint duration, float delay, bool loop = false):
-		Sprite()
+		AnimatedSprite(texture, GetAnimationLibrary().addStrip(x, y, width, height, duration, delay, loop))
 	{
-		data.end       = duration;
-		data.delay     = delay;
-		data.is_looped = loop;
-		data.frames.reserve(duration);
+	}
 
-		for (std::size_t i = 0; i < duration; ++i)
-			data.frames.emplace_back(x + i * width, y, width, height);
+	AnimatedSprite(Texture* texture, ClipId clip, const AnimationLibrary& clips = GetAnimationLibrary()):
+		Sprite(), library(&clips)
+	{
+		state.clip = clip;
 
 		setTexture(texture);
-		setTextureRect(data.frames[0]);
+		setTextureRect(library->get(clip).frames[0]);
 	}
 
 	void tick(float delta_time)
 	{
-		data.elapsed_time += delta_time;
+		const AnimationClip& clip = library->get(state.clip);
 
-		if (data.elapsed_time >= data.delay)
-		{
-			data.elapsed_time = 0;
-			data.current_frame++;
-
-			if (isEnd())			
-				if (!data.is_looped)			
-					return;			
-				else
-					data.current_frame = 0;
-			
-			setTextureRect(data.frames[data.current_frame]);
-		}
+		if (AdvanceAnimation(clip, state, delta_time))
+			setTextureRect(GetShownFrame(clip, state));
 	}
 
 	void reset()
 	{
-		data.reset();
-		setTextureRect(data.frames[0]);
+		state.reset();
+		setTextureRect(library->get(state.clip).frames[0]);
 	}
 
 	bool isEnd() const
 	{
-		return data.current_frame == data.end;
+		const AnimationClip& clip = library->get(state.clip);
+		return !clip.is_looped && state.frame == clip.frames.size();
 	}
 
 private:
-	AnimationData data;
+	const AnimationLibrary* library;
+	AnimationState          state;
 };
 
 // Sprite with multiple animation. Important! Animation playing cycle sets by manual control (play/pause) ! 
 class AnimationManager : public Sprite
 {
 public:
-	AnimationManager(): Sprite(), is_playing(false)
+	explicit AnimationManager(AnimationLibrary& clips = GetAnimationLibrary()):
+		Sprite(), is_playing(false), library(&clips)
 	{
 	}
 
@@ -92,48 +230,58 @@ public:
 	{
 	}
 
-	void add(const std::string_view name, GLuint x, GLuint y, GLuint width, GLuint height, GLuint duration, float delay)
+	// Defines a looped clip and switches to it. Names belong to this sprite, only the frames are shared:
+	// sprites defining the same strip get the same clip. Keep the returned id for set(), names are meant for setup only
+	ClipId add(const std::string_view name, GLuint x, GLuint y, GLuint width, GLuint height, GLuint duration, float delay)
 	{
-		AnimationData data;
-		data.end   = duration;
-		data.delay = delay;
-		data.frames.reserve(duration);
+		ClipId clip = library->addStrip(x, y, width, height, duration, delay, true);
 
-		for (std::size_t i = 0; i < duration; ++i)
-			data.frames.emplace_back(x + i * width, y, width, height);
-		
-		anim_list.emplace(name, std::move(data));
-		set(name);
+		if (clip != INVALID_CLIP)
+			names.insert_or_assign(std::string(name), clip);
+
+		set(clip);
+
+		return clip;
 	}
 
+	// Switching restarts the clip, setting the current one again changes nothing
+	void set(ClipId clip)
+	{
+		if (clip != state.clip && clip != INVALID_CLIP)
+		{
+			state.clip = clip;
+			state.reset();
+			setTextureRect(library->get(clip).frames[0]);
+		}
+	}
+
+	// Convenience for setup code, costs a name lookup. Names given to add() only
 	void set(const std::string_view name)
 	{
-		if(current_anim != name)
-		//if (anim_list.find(name) != anim_list.end())
+		auto found = names.find(name);
+
+		if (found == names.end())
 		{
-			anim_list[current_anim].reset();
-			current_anim = name;
-			setTextureRect(anim_list[current_anim].frames[0]);
-		}			
+			std::cout << "Animation clip " << name << " is not defined\n";
+			return;
+		}
+
+		set(found->second);
 	}
 
-	void tick(float delta_time)
+	ClipId getClip() const
 	{
-		if (!is_playing) return;
+		return state.clip;
+	}
 
-		AnimationData& anim = anim_list[current_anim];
-		anim.elapsed_time += delta_time;
+	void tick(float delta_time)
+	{
+		if (!is_playing || state.clip == INVALID_CLIP) return;
 
-		if (anim.elapsed_time >= anim.delay)
-		{
-			anim.elapsed_time = 0;
-			anim.current_frame++;
+		const AnimationClip& clip = library->get(state.clip);
 
-			if (anim.current_frame == anim.end)		
-				anim.current_frame = 0;
-			
-			setTextureRect(anim.frames[anim.current_frame]);
-		}
+		if (AdvanceAnimation(clip, state, delta_time))
+			setTextureRect(GetShownFrame(clip, state));
 	}
 
 	void play()
@@ -152,7 +300,8 @@ public:
 	}
 
 private:
-	bool is_playing;
-	std::string_view current_anim;
-	std::map<std::string_view, AnimationData> anim_list;
+	bool                                       is_playing;
+	AnimationLibrary*                          library;
+	AnimationState                             state;
+	std::map<std::string, ClipId, std::less<>> names;
 };
\ No newline at end of file
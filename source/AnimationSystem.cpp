@@ -0,0 +1,187 @@
+#include "AnimationSystem.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+
+AnimationSystem::AnimationSystem(const AnimationLibrary& library, unsigned thread_count):
+	library(library),
+	generation(0),
+	running_workers(0),
+	step_time(0),
+	is_running(true)
+{
+	// The calling thread takes a share of the work itself
+	const unsigned chunk_count = std::max(thread_count, 1u);
+
+	chunk_changed.resize(chunk_count);
+
+	for (std::size_t chunk = 1; chunk < chunk_count; ++chunk)
+		workers.emplace_back(&AnimationSystem::work, this, chunk);
+}
+
+AnimationSystem::~AnimationSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(pool_mutex);
+		is_running = false;
+	}
+	start_condition.notify_all();
+
+	for (auto& worker : workers)
+		worker.join();
+}
+
+AnimationSystem::Handle AnimationSystem::add(SpriteBatch& batch, SpriteBatch::InstanceId instance, ClipId clip, bool is_playing)
+{
+	const auto handle = static_cast<Handle>(states.size());
+
+	AnimationState& state = states.emplace_back();
+	state.clip = clip;
+
+	playing.push_back(is_playing);
+	batches.push_back(&batch);
+	instances.push_back(instance);
+
+	showFrame(handle);
+
+	return handle;
+}
+
+void AnimationSystem::set(Handle handle, ClipId clip)
+{
+	if (states[handle].clip == clip)
+		return;
+
+	states[handle].clip = clip;
+	states[handle].reset();
+
+	showFrame(handle);
+}
+
+void AnimationSystem::play(Handle handle)
+{
+	playing[handle] = true;
+}
+
+void AnimationSystem::pause(Handle handle)
+{
+	playing[handle] = false;
+}
+
+const AnimationState& AnimationSystem::getState(Handle handle) const
+{
+	return states[handle];
+}
+
+std::size_t AnimationSystem::size() const
+{
+	return states.size();
+}
+
+void AnimationSystem::update(float delta_time)
+{
+	PROFILE_SCOPE("AnimationSystem::update");
+
+	changed.clear();
+
+	if (states.size() < PARALLEL_THRESHOLD || workers.empty())
+	{
+		advance(0, 1, delta_time);
+		changed.swap(chunk_changed[0]);
+	}
+	else
+	{
+		{
+			std::lock_guard<std::mutex> lock(pool_mutex);
+			step_time       = delta_time;
+			running_workers = workers.size();
+			++generation;
+		}
+		start_condition.notify_all();
+
+		advance(0, chunk_changed.size(), delta_time);
+
+		std::unique_lock<std::mutex> lock(pool_mutex);
+		done_condition.wait(lock, [this] { return running_workers == 0; });
+
+		// Chunks are consecutive ranges, merged in order the list stays sorted
+		for (const auto& chunk : chunk_changed)
+			changed.insert(changed.end(), chunk.begin(), chunk.end());
+	}
+
+	// Serial part: batches are not thread safe and few animations change frame per update
+	for (Handle handle : changed)
+		showFrame(handle);
+}
+
+const std::vector<AnimationSystem::Handle>& AnimationSystem::getChanged() const
+{
+	return changed;
+}
+
+void AnimationSystem::advance(std::size_t chunk, std::size_t chunk_count, float delta_time)
+{
+	const std::size_t begin       = states.size() * chunk / chunk_count;
+	const std::size_t end         = states.size() * (chunk + 1) / chunk_count;
+
+	auto& result = chunk_changed[chunk];
+	result.clear();
+
+	for (std::size_t i = begin; i < end; ++i)
+	{
+		if (!playing[i] || states[i].clip == INVALID_CLIP)
+			continue;
+
+		if (AdvanceAnimation(library.get(states[i].clip), states[i], delta_time))
+			result.push_back(static_cast<Handle>(i));
+	}
+}
+
+void AnimationSystem::work(std::size_t chunk)
+{
+	Profiler::setThreadName("Animation worker");
+
+	std::uint64_t seen_generation = 0;
+
+	for (;;)
+	{
+		float delta_time;
+		{
+			std::unique_lock<std::mutex> lock(pool_mutex);
+			start_condition.wait(lock, [&] { return !is_running || generation != seen_generation; });
+
+			if (!is_running)
+				return;
+
+			seen_generation = generation;
+			delta_time      = step_time;
+		}
+
+		{
+			PROFILE_SCOPE("AnimationSystem::advance");
+			advance(chunk, chunk_changed.size(), delta_time);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(pool_mutex);
+
+			if (--running_workers == 0)
+				done_condition.notify_one();
+		}
+	}
+}
+
+void AnimationSystem::showFrame(Handle handle)
+{
+	const AnimationState& state = states[handle];
+
+	if (state.clip == INVALID_CLIP)
+		return;
+
+	const AnimationClip& clip = library.get(state.clip);
+
+	if (clip.frames.empty())
+		return;
+
+	batches[handle]->setTextureRect(instances[handle], GetShownFrame(clip, state));
+}
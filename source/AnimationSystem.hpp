@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Animation.hpp"
+#include "SpriteBatch.hpp"
+
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Plays animations for instances of sprite batches. All playback states advance in one data-parallel pass
+// split across a pool of worker threads, then the instances whose frame changed get their new texture rects.
+// update() makes no GL calls: the rects land in the batches' CPU copies and go up with their next upload
+class AnimationSystem
+{
+public:
+	using Handle = std::uint32_t;
+
+	// Below this many animations the pass runs on the calling thread only
+	static constexpr std::size_t PARALLEL_THRESHOLD = 4096;
+
+	explicit AnimationSystem(const AnimationLibrary& library = GetAnimationLibrary(),
+	                         unsigned thread_count = std::thread::hardware_concurrency());
+	AnimationSystem(const AnimationSystem&) = delete;
+	AnimationSystem& operator = (const AnimationSystem&) = delete;
+	~AnimationSystem();
+
+	// The instance shows the first frame of the clip at once
+	Handle add(SpriteBatch& batch, SpriteBatch::InstanceId instance, ClipId clip, bool playing = true);
+	// Restarts only when the clip differs from the current one
+	void set(Handle handle, ClipId clip);
+	void play(Handle handle);
+	void pause(Handle handle);
+
+	const AnimationState& getState(Handle handle) const;
+	std::size_t           size() const;
+
+	void update(float delta_time);
+	// Animations which changed their frame in the last update, in ascending order
+	const std::vector<Handle>& getChanged() const;
+
+private:
+	// Steps the chunk'th of chunk_count consecutive ranges of the states
+	void advance(std::size_t chunk, std::size_t chunk_count, float delta_time);
+	void work(std::size_t chunk);
+	void showFrame(Handle handle);
+
+	const AnimationLibrary& library;
+
+	// One entry per animation, indexed by handle
+	std::vector<AnimationState>          states;
+	std::vector<std::uint8_t>            playing;
+	std::vector<SpriteBatch*>            batches;
+	std::vector<SpriteBatch::InstanceId> instances;
+
+	std::vector<Handle>              changed;
+	std::vector<std::vector<Handle>> chunk_changed; // Chunk 0 belongs to the calling thread
+
+	std::vector<std::thread> workers;
+	std::mutex               pool_mutex;
+	std::condition_variable  start_condition;
+	std::condition_variable  done_condition;
+	std::uint64_t            generation;
+	std::size_t              running_workers;
+	float                    step_time;
+	bool                     is_running;
+};
@@ -0,0 +1,717 @@
+#include "BlockCompression.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+	// Principal axis of a point cloud by power iteration over the covariance matrix
+	template<int N>
+	void FindPrincipalAxis(const float (*points)[4], int count, float* mean, float* axis)
+	{
+		for (int c = 0; c < N; ++c)
+		{
+			mean[c] = 0.0f;
+			for (int i = 0; i < count; ++i)
+				mean[c] += points[i][c];
+			mean[c] /= count;
+		}
+
+		float covariance[N][N] {};
+
+		for (int i = 0; i < count; ++i)
+			for (int a = 0; a < N; ++a)
+				for (int b = 0; b < N; ++b)
+					covariance[a][b] += (points[i][a] - mean[a]) * (points[i][b] - mean[b]);
+
+		for (int c = 0; c < N; ++c)
+			axis[c] = 1.0f;
+
+		for (int iteration = 0; iteration < 8; ++iteration)
+		{
+			float next[N] {};
+			float length = 0.0f;
+
+			for (int a = 0; a < N; ++a)
+			{
+				for (int b = 0; b < N; ++b)
+					next[a] += covariance[a][b] * axis[b];
+
+				length = std::max(length, std::fabs(next[a]));
+			}
+
+			if (length == 0.0f) break; // All points are equal
+
+			for (int c = 0; c < N; ++c)
+				axis[c] = next[c] / length;
+		}
+	}
+
+	template<int N>
+	void FindEndpoints(const float (*points)[4], int count, float* low, float* high)
+	{
+		float mean[N], axis[N];
+		FindPrincipalAxis<N>(points, count, mean, axis);
+
+		float length = 0.0f;
+		for (int c = 0; c < N; ++c)
+			length += axis[c] * axis[c];
+
+		float t_min = 0.0f, t_max = 0.0f;
+
+		if (length > 0.0f)
+		{
+			length = std::sqrt(length);
+
+			for (int c = 0; c < N; ++c)
+				axis[c] /= length;
+
+			for (int i = 0; i < count; ++i)
+			{
+				float t = 0.0f;
+				for (int c = 0; c < N; ++c)
+					t += (points[i][c] - mean[c]) * axis[c];
+
+				t_min = std::min(t_min, t);
+				t_max = std::max(t_max, t);
+			}
+		}
+
+		for (int c = 0; c < N; ++c)
+		{
+			low[c]  = std::clamp(mean[c] + axis[c] * t_min, 0.0f, 255.0f);
+			high[c] = std::clamp(mean[c] + axis[c] * t_max, 0.0f, 255.0f);
+		}
+	}
+
+	std::uint16_t PackColor565(const float* color)
+	{
+		unsigned r = static_cast<unsigned>(std::lround(color[0] * 31.0f / 255.0f));
+		unsigned g = static_cast<unsigned>(std::lround(color[1] * 63.0f / 255.0f));
+		unsigned b = static_cast<unsigned>(std::lround(color[2] * 31.0f / 255.0f));
+
+		return static_cast<std::uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	void UnpackColor565(std::uint16_t color, int* rgb)
+	{
+		int r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+
+		rgb[0] = (r << 3) | (r >> 2);
+		rgb[1] = (g << 2) | (g >> 4);
+		rgb[2] = (b << 3) | (b >> 2);
+	}
+
+	void BuildPaletteBC1(std::uint16_t color0, std::uint16_t color1, int (*palette)[4])
+	{
+		UnpackColor565(color0, palette[0]);
+		UnpackColor565(color1, palette[1]);
+		palette[0][3] = palette[1][3] = 255;
+
+		for (int c = 0; c < 3; ++c)
+		{
+			if (color0 > color1)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+			else
+			{
+				palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+				palette[3][c] = 0;
+			}
+		}
+		palette[2][3] = 255;
+		palette[3][3] = color0 > color1 ? 255 : 0;
+	}
+
+	const int BC7_WEIGHTS_2[4]  { 0, 21, 43, 64 };
+	const int BC7_WEIGHTS_4[16] { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	int Interpolate(int a, int b, int weight)
+	{
+		return ((64 - weight) * a + weight * b + 32) >> 6;
+	}
+
+	class BitStream
+	{
+	public:
+		explicit BitStream(unsigned char* bytes) : bytes(bytes), position(0)
+		{
+		}
+
+		void write(unsigned value, unsigned count)
+		{
+			for (unsigned i = 0; i < count; ++i, ++position)
+				if ((value >> i) & 1)
+					bytes[position >> 3] |= 1 << (position & 7);
+		}
+
+		unsigned read(unsigned count)
+		{
+			unsigned value = 0;
+
+			for (unsigned i = 0; i < count; ++i, ++position)
+				value |= ((bytes[position >> 3] >> (position & 7)) & 1u) << i;
+
+			return value;
+		}
+
+	private:
+		unsigned char* bytes;
+		unsigned       position;
+	};
+
+	// Picks for every point the closest of the palette entries, over the given channels. Returns the total error
+	float FindIndices(const float (*points)[4], const int (*palette)[4], int palette_size, int first_channel, int channel_count, unsigned* indices)
+	{
+		float total_error = 0.0f;
+
+		for (int i = 0; i < 16; ++i)
+		{
+			float best_error = 1e30f;
+
+			for (int p = 0; p < palette_size; ++p)
+			{
+				float error = 0.0f;
+				for (int c = first_channel; c < first_channel + channel_count; ++c)
+					error += (points[i][c] - palette[p][c]) * (points[i][c] - palette[p][c]);
+
+				if (error < best_error)
+				{
+					best_error = error;
+					indices[i] = p;
+				}
+			}
+			total_error += best_error;
+		}
+		return total_error;
+	}
+
+	// Least squares endpoints for the given interpolation weights. Returns false for a degenerate system
+	bool RefitEndpoints(const float (*points)[4], const unsigned* indices, const int* weights, int first_channel, int channel_count, float (*endpoints)[4])
+	{
+		float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+		float ax[4] {}, bx[4] {};
+
+		for (int i = 0; i < 16; ++i)
+		{
+			float w = weights[indices[i]] / 64.0f;
+
+			aa += (1.0f - w) * (1.0f - w);
+			ab += (1.0f - w) * w;
+			bb += w * w;
+
+			for (int c = first_channel; c < first_channel + channel_count; ++c)
+			{
+				ax[c] += (1.0f - w) * points[i][c];
+				bx[c] += w * points[i][c];
+			}
+		}
+
+		float determinant = aa * bb - ab * ab;
+		if (std::fabs(determinant) < 1e-6f) return false;
+
+		for (int c = first_channel; c < first_channel + channel_count; ++c)
+		{
+			endpoints[0][c] = std::clamp((bb * ax[c] - ab * bx[c]) / determinant, 0.0f, 255.0f);
+			endpoints[1][c] = std::clamp((aa * bx[c] - ab * ax[c]) / determinant, 0.0f, 255.0f);
+		}
+		return true;
+	}
+
+	// Mode 6: one subset, RGBA endpoints of 7 bits plus a low bit per endpoint, 4 bit indices
+	void EncodeBC7Mode6(const float (*points)[4], unsigned char* output)
+	{
+		float endpoints[2][4];
+		FindEndpoints<4>(points, 16, endpoints[0], endpoints[1]);
+
+		unsigned quantized[2][4], p_bits[2];
+		int      palette[16][4];
+		unsigned indices[16];
+
+		auto quantize = [&]()
+		{
+			for (int e = 0; e < 2; ++e)
+			{
+				float best_error = 1e30f;
+
+				for (unsigned p = 0; p < 2; ++p)
+				{
+					unsigned candidate[4];
+					float    error = 0.0f;
+
+					for (int c = 0; c < 4; ++c)
+					{
+						long q = std::lround((endpoints[e][c] - p) * 0.5f);
+						candidate[c] = static_cast<unsigned>(std::clamp(q, 0l, 127l));
+
+						float difference = float(candidate[c] * 2 + p) - endpoints[e][c];
+						error += difference * difference;
+					}
+
+					if (error < best_error)
+					{
+						best_error = error;
+						p_bits[e] = p;
+						std::copy(candidate, candidate + 4, quantized[e]);
+					}
+				}
+			}
+
+			for (int i = 0; i < 16; ++i)
+				for (int c = 0; c < 4; ++c)
+					palette[i][c] = Interpolate(quantized[0][c] * 2 + p_bits[0], quantized[1][c] * 2 + p_bits[1], BC7_WEIGHTS_4[i]);
+		};
+
+		quantize();
+		float best_error = FindIndices(points, palette, 16, 0, 4, indices);
+
+		for (int iteration = 0; iteration < 2 && best_error > 0.0f; ++iteration)
+		{
+			unsigned previous_quantized[2][4], previous_p_bits[2];
+			std::memcpy(previous_quantized, quantized, sizeof(quantized));
+			std::memcpy(previous_p_bits, p_bits, sizeof(p_bits));
+
+			if (!RefitEndpoints(points, indices, BC7_WEIGHTS_4, 0, 4, endpoints))
+				break;
+
+			quantize();
+
+			unsigned candidate[16];
+			float error = FindIndices(points, palette, 16, 0, 4, candidate);
+
+			if (error >= best_error)
+			{
+				std::memcpy(quantized, previous_quantized, sizeof(quantized));
+				std::memcpy(p_bits, previous_p_bits, sizeof(p_bits));
+				break;
+			}
+			best_error = error;
+			std::copy(candidate, candidate + 16, indices);
+		}
+
+		// The first index is stored without its top bit, so it must stay below 8
+		if (indices[0] & 8)
+		{
+			std::swap(quantized[0], quantized[1]);
+			std::swap(p_bits[0], p_bits[1]);
+
+			for (auto& index : indices)
+				index = 15 - index;
+		}
+
+		std::memset(output, 0, 16);
+		BitStream stream(output);
+
+		stream.write(1 << 6, 7);
+
+		for (int c = 0; c < 4; ++c)
+		{
+			stream.write(quantized[0][c], 7);
+			stream.write(quantized[1][c], 7);
+		}
+		stream.write(p_bits[0], 1);
+		stream.write(p_bits[1], 1);
+
+		stream.write(indices[0], 3);
+		for (int i = 1; i < 16; ++i)
+			stream.write(indices[i], 4);
+	}
+
+	// Mode 5: one subset, RGB endpoints of 7 bits and alpha of 8 bits with their own 2 bit indices
+	void EncodeBC7Mode5(const float (*points)[4], unsigned char* output)
+	{
+		float endpoints[2][4];
+		FindEndpoints<3>(points, 16, endpoints[0], endpoints[1]);
+
+		endpoints[0][3] = endpoints[1][3] = points[0][3];
+		for (int i = 1; i < 16; ++i)
+		{
+			endpoints[0][3] = std::min(endpoints[0][3], points[i][3]);
+			endpoints[1][3] = std::max(endpoints[1][3], points[i][3]);
+		}
+
+		unsigned color[2][3], alpha[2];
+		int      palette[4][4];
+		unsigned color_indices[16], alpha_indices[16];
+
+		auto quantize = [&]()
+		{
+			for (int e = 0; e < 2; ++e)
+			{
+				for (int c = 0; c < 3; ++c)
+					color[e][c] = static_cast<unsigned>(std::clamp(std::lround(endpoints[e][c] * 127.0f / 255.0f), 0l, 127l));
+
+				alpha[e] = static_cast<unsigned>(std::clamp(std::lround(endpoints[e][3]), 0l, 255l));
+			}
+
+			for (int i = 0; i < 4; ++i)
+			{
+				for (int c = 0; c < 3; ++c)
+					palette[i][c] = Interpolate((color[0][c] << 1) | (color[0][c] >> 6), (color[1][c] << 1) | (color[1][c] >> 6), BC7_WEIGHTS_2[i]);
+
+				palette[i][3] = Interpolate(alpha[0], alpha[1], BC7_WEIGHTS_2[i]);
+			}
+		};
+
+		quantize();
+		float best_error = FindIndices(points, palette, 4, 0, 3, color_indices);
+
+		for (int iteration = 0; iteration < 2 && best_error > 0.0f; ++iteration)
+		{
+			// quantize() works from the endpoints, so they are what has to be restored
+			float previous[2][4];
+			std::memcpy(previous, endpoints, sizeof(endpoints));
+
+			if (!RefitEndpoints(points, color_indices, BC7_WEIGHTS_2, 0, 3, endpoints))
+				break;
+
+			quantize();
+
+			unsigned candidate[16];
+			float error = FindIndices(points, palette, 4, 0, 3, candidate);
+
+			if (error >= best_error)
+			{
+				std::memcpy(endpoints, previous, sizeof(endpoints));
+				quantize();
+				break;
+			}
+			best_error = error;
+			std::copy(candidate, candidate + 16, color_indices);
+		}
+
+		FindIndices(points, palette, 4, 3, 1, alpha_indices);
+
+		// The first index of each set is stored without its top bit
+		if (color_indices[0] & 2)
+		{
+			std::swap(color[0], color[1]);
+			for (auto& index : color_indices)
+				index = 3 - index;
+		}
+
+		if (alpha_indices[0] & 2)
+		{
+			std::swap(alpha[0], alpha[1]);
+			for (auto& index : alpha_indices)
+				index = 3 - index;
+		}
+
+		std::memset(output, 0, 16);
+		BitStream stream(output);
+
+		stream.write(1 << 5, 6);
+		stream.write(0, 2); // No channel rotation
+
+		for (int c = 0; c < 3; ++c)
+		{
+			stream.write(color[0][c], 7);
+			stream.write(color[1][c], 7);
+		}
+		stream.write(alpha[0], 8);
+		stream.write(alpha[1], 8);
+
+		stream.write(color_indices[0], 1);
+		for (int i = 1; i < 16; ++i)
+			stream.write(color_indices[i], 2);
+
+		stream.write(alpha_indices[0], 1);
+		for (int i = 1; i < 16; ++i)
+			stream.write(alpha_indices[i], 2);
+	}
+}
+
+std::size_t GetImageSize(BlockFormat format, unsigned width, unsigned height)
+{
+	const std::size_t blocks = std::size_t((width + 3) / 4) * ((height + 3) / 4);
+
+	switch (format)
+	{
+		case BlockFormat::BC1: return blocks * 8;
+		case BlockFormat::BC7: return blocks * 16;
+		default:               return std::size_t(width) * height * 4;
+	}
+}
+
+void EncodeBC1Block(const unsigned char* rgba_block, unsigned char* output)
+{
+	float points[16][4];
+	int   count = 0;
+	bool  has_transparent = false;
+
+	for (int i = 0; i < 16; ++i)
+	{
+		const unsigned char* pixel = rgba_block + i * 4;
+
+		if (pixel[3] < 128)
+			has_transparent = true;
+		else
+		{
+			points[count][0] = pixel[0];
+			points[count][1] = pixel[1];
+			points[count][2] = pixel[2];
+			count++;
+		}
+	}
+
+	std::uint16_t color0 = 0, color1 = 0;
+
+	if (count > 0)
+	{
+		float low[3], high[3];
+		FindEndpoints<3>(points, count, low, high);
+
+		color0 = PackColor565(high);
+		color1 = PackColor565(low);
+
+		// The endpoint order selects the mode: color0 > color1 - four colors, otherwise three colors and transparent
+		if ((color0 < color1) != has_transparent && color0 != color1)
+			std::swap(color0, color1);
+	}
+
+	int palette[4][4];
+	BuildPaletteBC1(color0, color1, palette);
+
+	const int colors = color0 > color1 ? 4 : 3;
+	std::uint32_t indices = 0;
+
+	for (int i = 0; i < 16; ++i)
+	{
+		const unsigned char* pixel = rgba_block + i * 4;
+		unsigned best = 3;
+
+		if (pixel[3] >= 128 || colors == 4)
+		{
+			int best_error = 0x7FFFFFFF;
+
+			for (int p = 0; p < colors; ++p)
+			{
+				int error = 0;
+				for (int c = 0; c < 3; ++c)
+					error += (pixel[c] - palette[p][c]) * (pixel[c] - palette[p][c]);
+
+				if (error < best_error)
+				{
+					best_error = error;
+					best = p;
+				}
+			}
+		}
+		indices |= best << (i * 2);
+	}
+
+	output[0] = color0 & 0xFF;
+	output[1] = color0 >> 8;
+	output[2] = color1 & 0xFF;
+	output[3] = color1 >> 8;
+
+	for (int i = 0; i < 4; ++i)
+		output[4 + i] = (indices >> (i * 8)) & 0xFF;
+}
+
+void DecodeBC1Block(const unsigned char* input, unsigned char* rgba_block)
+{
+	std::uint16_t color0 = input[0] | (input[1] << 8);
+	std::uint16_t color1 = input[2] | (input[3] << 8);
+	std::uint32_t indices = input[4] | (input[5] << 8) | (input[6] << 16) | (std::uint32_t(input[7]) << 24);
+
+	int palette[4][4];
+	BuildPaletteBC1(color0, color1, palette);
+
+	for (int i = 0; i < 16; ++i)
+		for (int c = 0; c < 4; ++c)
+			rgba_block[i * 4 + c] = static_cast<unsigned char>(palette[(indices >> (i * 2)) & 3][c]);
+}
+
+void EncodeBC7Block(const unsigned char* rgba_block, unsigned char* output)
+{
+	// Colors of fully transparent texels are invisible, they take the average opaque color to not disturb the fit
+	float points[16][4];
+	float opaque_sum[3] {};
+	int   opaque_count = 0;
+
+	for (int i = 0; i < 16; ++i)
+		if (rgba_block[i * 4 + 3] > 0)
+		{
+			for (int c = 0; c < 3; ++c)
+				opaque_sum[c] += rgba_block[i * 4 + c];
+			opaque_count++;
+		}
+
+	for (int i = 0; i < 16; ++i)
+		for (int c = 0; c < 4; ++c)
+			points[i][c] = (c < 3 && rgba_block[i * 4 + 3] == 0 && opaque_count) ? opaque_sum[c] / opaque_count : rgba_block[i * 4 + c];
+
+	// Mode 6 interpolates color and alpha together, mode 5 keeps separate alpha indices (better for cut-out sprites)
+	unsigned char candidates[2][16];
+	EncodeBC7Mode6(points, candidates[0]);
+	EncodeBC7Mode5(points, candidates[1]);
+
+	float best_error = 1e30f;
+
+	for (const auto& candidate : candidates)
+	{
+		unsigned char decoded[64];
+		DecodeBC7Block(candidate, decoded);
+
+		// Alpha errors weigh more: a texel meant to be fully transparent must stay so, e.g. for alpha testing
+		float error = 0.0f;
+		for (int i = 0; i < 16; ++i)
+			for (int c = 0; c < 4; ++c)
+				error += (decoded[i * 4 + c] - points[i][c]) * (decoded[i * 4 + c] - points[i][c]) * (c == 3 ? 16.0f : 1.0f);
+
+		if (error < best_error)
+		{
+			best_error = error;
+			std::memcpy(output, candidate, 16);
+		}
+	}
+}
+
+bool DecodeBC7Block(const unsigned char* input, unsigned char* rgba_block)
+{
+	unsigned char bytes[16];
+	std::memcpy(bytes, input, 16);
+	BitStream stream(bytes);
+
+	unsigned mode = 0;
+	while (mode < 8 && !stream.read(1))
+		mode++;
+
+	if (mode == 6)
+	{
+		int endpoints[2][4];
+
+		for (int c = 0; c < 4; ++c)
+		{
+			endpoints[0][c] = stream.read(7) << 1;
+			endpoints[1][c] = stream.read(7) << 1;
+		}
+
+		unsigned p0 = stream.read(1), p1 = stream.read(1);
+
+		for (int c = 0; c < 4; ++c)
+		{
+			endpoints[0][c] |= p0;
+			endpoints[1][c] |= p1;
+		}
+
+		for (int i = 0; i < 16; ++i)
+		{
+			unsigned index = stream.read(i == 0 ? 3 : 4);
+
+			for (int c = 0; c < 4; ++c)
+				rgba_block[i * 4 + c] = static_cast<unsigned char>(Interpolate(endpoints[0][c], endpoints[1][c], BC7_WEIGHTS_4[index]));
+		}
+		return true;
+	}
+
+	if (mode == 5)
+	{
+		unsigned rotation = stream.read(2);
+		int endpoints[2][4];
+
+		for (int c = 0; c < 3; ++c)
+			for (int e = 0; e < 2; ++e)
+			{
+				int value = stream.read(7);
+				endpoints[e][c] = (value << 1) | (value >> 6);
+			}
+
+		endpoints[0][3] = stream.read(8);
+		endpoints[1][3] = stream.read(8);
+
+		unsigned color_indices[16], alpha_indices[16];
+
+		for (int i = 0; i < 16; ++i)
+			color_indices[i] = stream.read(i == 0 ? 1 : 2);
+
+		for (int i = 0; i < 16; ++i)
+			alpha_indices[i] = stream.read(i == 0 ? 1 : 2);
+
+		for (int i = 0; i < 16; ++i)
+		{
+			unsigned char* pixel = rgba_block + i * 4;
+
+			for (int c = 0; c < 3; ++c)
+				pixel[c] = static_cast<unsigned char>(Interpolate(endpoints[0][c], endpoints[1][c], BC7_WEIGHTS_2[color_indices[i]]));
+
+			pixel[3] = static_cast<unsigned char>(Interpolate(endpoints[0][3], endpoints[1][3], BC7_WEIGHTS_2[alpha_indices[i]]));
+
+			if (rotation)
+				std::swap(pixel[3], pixel[rotation - 1]);
+		}
+		return true;
+	}
+	return false;
+}
+
+std::vector<unsigned char> CompressImage(const unsigned char* rgba_pixels, unsigned width, unsigned height, BlockFormat format)
+{
+	if (format == BlockFormat::RGBA8)
+		return std::vector<unsigned char>(rgba_pixels, rgba_pixels + GetImageSize(format, width, height));
+
+	const std::size_t block_size = format == BlockFormat::BC1 ? 8 : 16;
+
+	std::vector<unsigned char> blocks(GetImageSize(format, width, height));
+	unsigned char* output = blocks.data();
+
+	for (unsigned block_y = 0; block_y < height; block_y += 4)
+	{
+		for (unsigned block_x = 0; block_x < width; block_x += 4)
+		{
+			unsigned char block[64];
+
+			for (unsigned y = 0; y < 4; ++y)
+				for (unsigned x = 0; x < 4; ++x)
+				{
+					unsigned source_x = std::min(block_x + x, width - 1);
+					unsigned source_y = std::min(block_y + y, height - 1);
+
+					std::memcpy(block + (y * 4 + x) * 4, rgba_pixels + (std::size_t(source_y) * width + source_x) * 4, 4);
+				}
+
+			if (format == BlockFormat::BC1)
+				EncodeBC1Block(block, output);
+			else
+				EncodeBC7Block(block, output);
+
+			output += block_size;
+		}
+	}
+	return blocks;
+}
+
+std::vector<unsigned char> DecompressImage(const unsigned char* blocks, unsigned width, unsigned height, BlockFormat format)
+{
+	if (format == BlockFormat::RGBA8)
+		return std::vector<unsigned char>(blocks, blocks + GetImageSize(format, width, height));
+
+	const std::size_t block_size = format == BlockFormat::BC1 ? 8 : 16;
+
+	std::vector<unsigned char> pixels(std::size_t(width) * height * 4);
+
+	for (unsigned block_y = 0; block_y < height; block_y += 4)
+	{
+		for (unsigned block_x = 0; block_x < width; block_x += 4)
+		{
+			unsigned char block[64] {};
+
+			if (format == BlockFormat::BC1)
+				DecodeBC1Block(blocks, block);
+			else
+				DecodeBC7Block(blocks, block);
+
+			blocks += block_size;
+
+			for (unsigned y = 0; y < 4 && block_y + y < height; ++y)
+				for (unsigned x = 0; x < 4 && block_x + x < width; ++x)
+					std::memcpy(pixels.data() + (std::size_t(block_y + y) * width + block_x + x) * 4, block + (y * 4 + x) * 4, 4);
+		}
+	}
+	return pixels;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// GPU block formats produced by the texture baker. The codecs are plain CPU code without GL dependency
+enum class BlockFormat
+{
+	RGBA8, // Uncompressed fallback, 4 bytes per pixel
+	BC1,   // 8 bytes per 4x4 block, RGB with 1 bit alpha
+	BC7    // 16 bytes per 4x4 block, RGBA (encoded with modes 5 and 6)
+};
+
+std::size_t GetImageSize(BlockFormat format, unsigned width, unsigned height);
+
+// Blocks are 4x4 RGBA pixels, 64 bytes in row order
+void EncodeBC1Block(const unsigned char* rgba_block, unsigned char* output);
+void DecodeBC1Block(const unsigned char* input, unsigned char* rgba_block);
+void EncodeBC7Block(const unsigned char* rgba_block, unsigned char* output);
+// Decodes the modes the encoder produces (5 and 6), returns false for other modes
+bool DecodeBC7Block(const unsigned char* input, unsigned char* rgba_block);
+
+// Edge blocks of images with sizes not divisible by 4 are padded by repeating the last row and column
+std::vector<unsigned char> CompressImage(const unsigned char* rgba_pixels, unsigned width, unsigned height, BlockFormat format);
+std::vector<unsigned char> DecompressImage(const unsigned char* blocks, unsigned width, unsigned height, BlockFormat format);
@@ -0,0 +1,85 @@
+#include "Camera.hpp"
+#include "GLState.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+static_assert(sizeof(glm::mat4) == 64 && sizeof(glm::vec2) == 8, "Camera data must match the std140 block");
+
+Camera::Camera():
+	data{ glm::mat4(1.0f), glm::mat4(1.0f), glm::vec2(0.0f), 0.0f, 0.0f },
+	buffer(0),
+	need_update(true)
+{
+	if (GLState::hasDirectStateAccess())
+	{
+		glCreateBuffers(1, &buffer);
+		glNamedBufferStorage(buffer, sizeof(Data), nullptr, GL_DYNAMIC_STORAGE_BIT);
+	}
+	else
+	{
+		glGenBuffers(1, &buffer);
+		GLState::bindBuffer(GL_UNIFORM_BUFFER, buffer);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(Data), nullptr, GL_DYNAMIC_DRAW);
+	}
+}
+
+Camera::~Camera()
+{
+	glDeleteBuffers(1, &buffer);
+	GLState::onBuffersDeleted(1, &buffer);
+}
+
+void Camera::setViewport(const glm::vec2& size)
+{
+	if (data.viewport == size)
+		return;
+
+	data.viewport   = size;
+	data.projection = glm::ortho(0.0f, size.x, size.y, 0.0f, 0.0f, 1.0f);
+	need_update     = true;
+}
+
+void Camera::setProjection(const glm::mat4& projection)
+{
+	data.projection = projection;
+	need_update     = true;
+}
+
+void Camera::setView(const glm::mat4& view)
+{
+	data.view   = view;
+	need_update = true;
+}
+
+void Camera::setTime(float seconds)
+{
+	data.time   = seconds;
+	need_update = true;
+}
+
+const glm::mat4& Camera::getProjection() const
+{
+	return data.projection;
+}
+
+const glm::mat4& Camera::getView() const
+{
+	return data.view;
+}
+
+glm::vec2 Camera::getViewport() const
+{
+	return data.viewport;
+}
+
+void Camera::update()
+{
+	if (need_update)
+	{
+		GLState::uploadBuffer(GL_UNIFORM_BUFFER, buffer, 0, sizeof(Data), &data);
+		need_update = false;
+	}
+
+	// Other code may have used the binding point in between
+	GLState::bindBufferBase(GL_UNIFORM_BUFFER, BINDING, buffer);
+}
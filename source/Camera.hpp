@@ -0,0 +1,47 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+// Per frame values shared by all programs through one uniform buffer. Shaders declare
+//   layout (std140, binding = 0) uniform Camera { mat4 projection; mat4 view; vec2 viewport; float time; };
+// and the buffer is uploaded once per frame, however many programs read it.
+class Camera
+{
+public:
+	static constexpr GLuint BINDING = 0;
+
+	Camera();
+	Camera(const Camera&) = delete;
+	Camera& operator = (const Camera&) = delete;
+	~Camera();
+
+	// Also sets a pixel space projection: origin at the top left, y going down
+	void setViewport(const glm::vec2& size);
+	void setProjection(const glm::mat4& projection);
+	void setView(const glm::mat4& view);
+	void setTime(float seconds);
+
+	const glm::mat4& getProjection() const;
+	const glm::mat4& getView()       const;
+	glm::vec2        getViewport()   const;
+
+	// Uploads the changed values and binds the buffer to BINDING. Call once per frame before drawing
+	void update();
+
+private:
+	// std140 layout of the block
+	struct Data
+	{
+		glm::mat4 projection;
+		glm::mat4 view;
+		glm::vec2 viewport;
+		float     time;
+		float     padding;
+	};
+
+	Data   data;
+	GLuint buffer;
+	bool   need_update;
+};
@@ -0,0 +1,253 @@
+#include "GLState.hpp"
+
+#include <cstring>
+
+namespace
+{
+	constexpr GLuint UNKNOWN      = 0xFFFFFFFF;
+	constexpr GLenum UNKNOWN_ENUM = 0;
+	constexpr GLuint MAX_UNITS    = 32;
+	constexpr int    BUFFER_SLOTS = 6;
+
+	struct State
+	{
+		GLuint program                  = 0;
+		GLuint vao                      = 0;
+		GLuint buffers[BUFFER_SLOTS]    = {};
+		GLuint active_unit              = 0;
+		GLuint textures[MAX_UNITS]      = {};
+		GLuint framebuffer              = 0;
+		int    blending                 = 0; // 0 - disabled, 1 - enabled, -1 - unknown
+		GLenum blend_source             = GL_ONE;
+		GLenum blend_destination        = GL_ZERO;
+	};
+
+	State             state;
+	GLState::Counters counters;
+}
+
+void GLState::useProgram(GLuint program)
+{
+	if (skip(state.program == program)) return;
+
+	state.program = program;
+	counters.program_binds++;
+	glUseProgram(program);
+}
+
+void GLState::bindVertexArray(GLuint vao)
+{
+	if (skip(state.vao == vao)) return;
+
+	state.vao = vao;
+	glBindVertexArray(vao);
+
+	// The element buffer binding is a part of the vertex array state
+	state.buffers[getBufferSlot(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+}
+
+void GLState::bindBuffer(GLenum target, GLuint buffer)
+{
+	int slot = getBufferSlot(target);
+
+	if (slot < 0)
+	{
+		counters.issued++;
+		glBindBuffer(target, buffer);
+		return;
+	}
+
+	if (skip(state.buffers[slot] == buffer)) return;
+
+	state.buffers[slot] = buffer;
+	glBindBuffer(target, buffer);
+}
+
+void GLState::bindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+	counters.issued++;
+	glBindBufferBase(target, index, buffer);
+
+	int slot = getBufferSlot(target);
+
+	if (slot >= 0)
+		state.buffers[slot] = buffer;
+}
+
+void GLState::bindTexture(GLuint unit, GLuint texture)
+{
+	if (unit >= MAX_UNITS)
+	{
+		counters.issued += 2;
+		counters.texture_binds++;
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		state.active_unit = UNKNOWN;
+		return;
+	}
+
+	if (!skip(state.active_unit == unit))
+	{
+		state.active_unit = unit;
+		glActiveTexture(GL_TEXTURE0 + unit);
+	}
+
+	if (skip(state.textures[unit] == texture)) return;
+
+	state.textures[unit] = texture;
+	counters.texture_binds++;
+	glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void GLState::bindFramebuffer(GLuint framebuffer)
+{
+	if (skip(state.framebuffer == framebuffer)) return;
+
+	state.framebuffer = framebuffer;
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+void GLState::setBlending(bool enable)
+{
+	if (skip(state.blending == static_cast<int>(enable))) return;
+
+	state.blending = enable;
+	enable ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
+}
+
+void GLState::setBlendFunc(GLenum source_factor, GLenum destination_factor)
+{
+	if (skip(state.blend_source == source_factor && state.blend_destination == destination_factor)) return;
+
+	state.blend_source      = source_factor;
+	state.blend_destination = destination_factor;
+	glBlendFunc(source_factor, destination_factor);
+}
+
+void GLState::onProgramDeleted(GLuint program)
+{
+	if (state.program == program)
+		state.program = UNKNOWN;
+}
+
+void GLState::onVertexArrayDeleted(GLuint vao)
+{
+	if (state.vao == vao)
+		state.vao = UNKNOWN;
+}
+
+void GLState::onBuffersDeleted(GLsizei count, const GLuint* buffers)
+{
+	for (GLsizei i = 0; i < count; ++i)
+		for (auto& bound : state.buffers)
+			if (bound == buffers[i])
+				bound = UNKNOWN;
+}
+
+void GLState::onTextureDeleted(GLuint texture)
+{
+	for (auto& bound : state.textures)
+		if (bound == texture)
+			bound = UNKNOWN;
+}
+
+void GLState::onFramebufferDeleted(GLuint framebuffer)
+{
+	if (state.framebuffer == framebuffer)
+		state.framebuffer = UNKNOWN;
+}
+
+bool GLState::hasDirectStateAccess()
+{
+	return GLAD_GL_VERSION_4_5 != 0;
+}
+
+bool GLState::hasExtension(const char* name)
+{
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+	for (GLint i = 0; i < count; ++i)
+		if (std::strcmp(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i)), name) == 0)
+			return true;
+
+	return false;
+}
+
+void GLState::uploadBuffer(GLenum target, GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data)
+{
+	onUpload(size);
+
+	if (hasDirectStateAccess())
+	{
+		glNamedBufferSubData(buffer, offset, size, data);
+		return;
+	}
+
+	bindBuffer(target, buffer);
+	glBufferSubData(target, offset, size, data);
+
+	if (unbind_after_use)
+		bindBuffer(target, 0);
+}
+
+void GLState::invalidate()
+{
+	state.program     = UNKNOWN;
+	state.vao         = UNKNOWN;
+	state.active_unit = UNKNOWN;
+	state.framebuffer = UNKNOWN;
+
+	for (auto& buffer : state.buffers)
+		buffer = UNKNOWN;
+
+	for (auto& texture : state.textures)
+		texture = UNKNOWN;
+
+	state.blending          = -1;
+	state.blend_source      = UNKNOWN_ENUM;
+	state.blend_destination = UNKNOWN_ENUM;
+}
+
+void GLState::onDraw(std::size_t triangles, std::size_t calls)
+{
+	counters.draw_calls += calls;
+	counters.triangles  += triangles;
+}
+
+void GLState::onUpload(std::size_t bytes)
+{
+	counters.buffer_uploads++;
+	counters.uploaded_bytes += bytes;
+}
+
+const GLState::Counters& GLState::getCounters()
+{
+	return counters;
+}
+
+void GLState::resetCounters()
+{
+	counters = Counters();
+}
+
+bool GLState::skip(bool is_redundant)
+{
+	is_redundant ? counters.skipped++ : counters.issued++;
+
+	return is_redundant;
+}
+
+int GLState::getBufferSlot(GLenum target)
+{
+	switch (target)
+	{
+		case GL_ARRAY_BUFFER:          return 0;
+		case GL_ELEMENT_ARRAY_BUFFER:  return 1;
+		case GL_UNIFORM_BUFFER:        return 2;
+		case GL_SHADER_STORAGE_BUFFER: return 3;
+		case GL_PIXEL_UNPACK_BUFFER:   return 4;
+		case GL_COPY_WRITE_BUFFER:     return 5;
+		default:                       return -1;
+	}
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+
+// Remembers what is bound in the current GL context and skips the calls that would change nothing.
+// All GL objects must be bound through it, otherwise the cached state goes stale (see invalidate()).
+class GLState
+{
+public:
+	// Totals since the start or the last reset. RenderStats turns them into per frame numbers
+	struct Counters
+	{
+		std::size_t issued  = 0; // State changes sent to GL
+		std::size_t skipped = 0;
+
+		std::size_t draw_calls     = 0;
+		std::size_t triangles      = 0;
+		std::size_t program_binds  = 0;
+		std::size_t texture_binds  = 0;
+		std::size_t buffer_uploads = 0;
+		std::size_t uploaded_bytes = 0;
+	};
+
+	// Unbinding after use only helps to catch errors, so release builds keep the last binding
+#ifdef NDEBUG
+	static constexpr bool unbind_after_use = false;
+#else
+	static constexpr bool unbind_after_use = true;
+#endif
+
+	static void useProgram(GLuint program);
+	static void bindVertexArray(GLuint vao);
+	static void bindBuffer(GLenum target, GLuint buffer);
+	// Indexed binding points (uniform and storage blocks). Always issued, it also changes the generic binding
+	static void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+	static void bindTexture(GLuint unit, GLuint texture);
+	// Draw and read framebuffer together, 0 is the default one
+	static void bindFramebuffer(GLuint framebuffer);
+	static void setBlending(bool enable);
+	static void setBlendFunc(GLenum source_factor, GLenum destination_factor);
+
+	// GL reuses the names of deleted objects, so the cache has to forget them
+	static void onProgramDeleted(GLuint program);
+	static void onVertexArrayDeleted(GLuint vao);
+	static void onBuffersDeleted(GLsizei count, const GLuint* buffers);
+	static void onTextureDeleted(GLuint texture);
+	static void onFramebufferDeleted(GLuint framebuffer);
+
+	// Direct State Access (GL 4.5+) lets objects be created and edited without binding them
+	static bool hasDirectStateAccess();
+
+	static bool hasExtension(const char* name);
+
+	// Updates a part of a buffer, binds it only when DSA is not available
+	static void uploadBuffer(GLenum target, GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data);
+
+	// Draw calls are issued by their owners, which report them here
+	static void onDraw(std::size_t triangles, std::size_t calls = 1);
+	// For uploads that don't go through uploadBuffer
+	static void onUpload(std::size_t bytes);
+
+	// Drops all the cached state. Call it after GL code that bypasses the cache
+	static void invalidate();
+
+	static const Counters& getCounters();
+	static void resetCounters();
+
+private:
+	static bool skip(bool is_redundant);
+	static int  getBufferSlot(GLenum target);
+};
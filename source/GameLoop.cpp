@@ -0,0 +1,67 @@
+#include "GameLoop.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+GameLoop::GameLoop(float step_time, unsigned max_steps):
+	step_time(step_time > 0 ? step_time : 1.0f / 60.0f),
+	max_steps(std::max(max_steps, 1u)),
+	accumulator(0),
+	frame_steps(0),
+	step_count(0),
+	dropped_frames(0)
+{
+}
+
+void GameLoop::beginFrame(float frame_time)
+{
+	// The clock can't run backwards, a stall (breakpoint, window drag) is cut by step()
+	accumulator += std::max(frame_time, 0.0f);
+	frame_steps  = 0;
+}
+
+bool GameLoop::step()
+{
+	if (accumulator < step_time)
+		return false;
+
+	if (frame_steps == max_steps)
+	{
+		// Spiral of death guard: simulating the backlog would make the next frame even longer.
+		// The fraction of a step is kept so the interpolation stays continuous
+		accumulator = std::fmod(accumulator, static_cast<double>(step_time));
+		dropped_frames++;
+		return false;
+	}
+
+	accumulator -= step_time;
+	frame_steps++;
+	step_count++;
+
+	return true;
+}
+
+float GameLoop::getInterpolation() const
+{
+	return static_cast<float>(accumulator / step_time);
+}
+
+float GameLoop::getStepTime() const
+{
+	return step_time;
+}
+
+double GameLoop::getTime() const
+{
+	return step_count * static_cast<double>(step_time);
+}
+
+std::uint64_t GameLoop::getStepCount() const
+{
+	return step_count;
+}
+
+std::uint64_t GameLoop::getDroppedFrames() const
+{
+	return dropped_frames;
+}
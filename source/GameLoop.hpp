@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+// Runs the simulation in fixed steps whatever the frame rate, so gameplay speed doesn't depend on it:
+//   loop.beginFrame(frame_time);
+//   while (loop.step()) { sprite.savePreviousState(); simulate(loop.getStepTime()); }
+//   sprite.setInterpolation(loop.getInterpolation());
+// Frames that take longer than max_steps steps drop the rest of their time instead of falling further behind
+class GameLoop
+{
+public:
+	explicit GameLoop(float step_time = 1.0f / 60.0f, unsigned max_steps = 5);
+
+	// Adds the real time the last frame took. Once per frame, before the steps
+	void beginFrame(float frame_time);
+	// True while another simulation step is due
+	bool step();
+
+	// How far the rendered frame is from the previous simulation state towards the current one, in [0, 1)
+	float         getInterpolation() const;
+	float         getStepTime()      const;
+	// Simulation time in whole steps since the start
+	double        getTime()          const;
+	std::uint64_t getStepCount()     const;
+	// Frames which hit max_steps and dropped time
+	std::uint64_t getDroppedFrames() const;
+
+private:
+	float         step_time;
+	unsigned      max_steps;
+	double        accumulator;
+	unsigned      frame_steps;
+	std::uint64_t step_count;
+	std::uint64_t dropped_frames;
+};
@@ -0,0 +1,335 @@
+#include "GraphicsContext.hpp"
+#include "NullGL.hpp"
+
+#include <cstdint>
+#include <initializer_list>
+#include <iostream>
+
+#ifdef __linux__
+#include <dlfcn.h>
+#endif
+
+namespace
+{
+	constexpr int GL_MAJOR = 4;
+	constexpr int GL_MINOR = 6;
+
+	// The few EGL and OSMesa definitions used here, the libraries are opened at run time
+	using EGLint     = std::int32_t;
+	using EGLBoolean = unsigned int;
+	using EGLenum    = unsigned int;
+
+	constexpr EGLint  EGL_NONE                             = 0x3038;
+	constexpr EGLint  EGL_RENDERABLE_TYPE                  = 0x3040;
+	constexpr EGLint  EGL_OPENGL_BIT                       = 0x0008;
+	constexpr EGLenum EGL_OPENGL_API                       = 0x30A2;
+	constexpr EGLint  EGL_CONTEXT_MAJOR_VERSION            = 0x3098;
+	constexpr EGLint  EGL_CONTEXT_MINOR_VERSION            = 0x30FB;
+	constexpr EGLint  EGL_CONTEXT_OPENGL_PROFILE_MASK      = 0x30FD;
+	constexpr EGLint  EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT  = 0x0001;
+	constexpr EGLenum EGL_PLATFORM_SURFACELESS_MESA        = 0x31DD;
+
+	using EglGetProcAddress        = void* (*)(const char*);
+	using EglGetPlatformDisplayExt = void* (*)(EGLenum, void*, const EGLint*);
+	using EglGetDisplay            = void* (*)(void*);
+	using EglInitialize            = EGLBoolean (*)(void*, EGLint*, EGLint*);
+	using EglTerminate             = EGLBoolean (*)(void*);
+	using EglBindApi               = EGLBoolean (*)(EGLenum);
+	using EglChooseConfig          = EGLBoolean (*)(void*, const EGLint*, void**, EGLint, EGLint*);
+	using EglCreateContext         = void* (*)(void*, void*, void*, const EGLint*);
+	using EglDestroyContext        = EGLBoolean (*)(void*, void*);
+	using EglMakeCurrent           = EGLBoolean (*)(void*, void*, void*, void*);
+
+	constexpr int OSMESA_RGBA                  = 0x1908;
+	constexpr int OSMESA_FORMAT                = 0x22;
+	constexpr int OSMESA_DEPTH_BITS            = 0x30;
+	constexpr int OSMESA_PROFILE               = 0x33;
+	constexpr int OSMESA_CORE_PROFILE          = 0x34;
+	constexpr int OSMESA_CONTEXT_MAJOR_VERSION = 0x36;
+	constexpr int OSMESA_CONTEXT_MINOR_VERSION = 0x37;
+
+	using OSMesaCreateContextAttribs = void* (*)(const int*, void*);
+	using OSMesaDestroyContext       = void (*)(void*);
+	using OSMesaMakeCurrent          = unsigned char (*)(void*, void*, GLenum, GLsizei, GLsizei);
+	using OSMesaGetProcAddress       = void* (*)(const char*);
+
+	// glad's loader takes a plain function, the library's lookup is kept here for it
+	EglGetProcAddress    egl_get_proc_address    = nullptr;
+	OSMesaGetProcAddress osmesa_get_proc_address = nullptr;
+
+	void* LoadEglFunction(const char* name)
+	{
+		return egl_get_proc_address(name);
+	}
+
+	void* LoadOSMesaFunction(const char* name)
+	{
+		return osmesa_get_proc_address(name);
+	}
+
+	void* OpenLibrary(std::initializer_list<const char*> names)
+	{
+#ifdef __linux__
+		for (const char* name : names)
+			if (void* library = dlopen(name, RTLD_NOW | RTLD_LOCAL))
+				return library;
+#endif
+		return nullptr;
+	}
+
+	template <typename Function>
+	Function GetFunction(void* library, const char* name)
+	{
+#ifdef __linux__
+		return reinterpret_cast<Function>(dlsym(library, name));
+#else
+		return nullptr;
+#endif
+	}
+
+	void CloseLibrary(void* library)
+	{
+#ifdef __linux__
+		if (library)
+			dlclose(library);
+#endif
+	}
+}
+
+GraphicsContext::GraphicsContext():
+	backend(ContextBackend::Window),
+	window(nullptr),
+	library(nullptr),
+	display(nullptr),
+	context(nullptr)
+{
+}
+
+GraphicsContext::~GraphicsContext()
+{
+	destroy();
+}
+
+bool GraphicsContext::parseBackend(std::string_view name, ContextBackend& backend)
+{
+	if (name == "window")
+		backend = ContextBackend::Window;
+	else if (name == "egl")
+		backend = ContextBackend::EglSurfaceless;
+	else if (name == "osmesa")
+		backend = ContextBackend::OSMesa;
+	else if (name == "null")
+		backend = ContextBackend::Null;
+	else
+		return false;
+
+	return true;
+}
+
+bool GraphicsContext::create(ContextBackend new_backend, const glm::ivec2& size, const char* title)
+{
+	destroy();
+	backend = new_backend;
+
+	bool is_created = false;
+
+	switch (backend)
+	{
+		case ContextBackend::Window:         is_created = createWindow(size, title); break;
+		case ContextBackend::EglSurfaceless: is_created = createEgl();               break;
+		case ContextBackend::OSMesa:         is_created = createOSMesa(size);        break;
+		case ContextBackend::Null:           is_created = NullGL::load();            break;
+	}
+
+	if (!is_created)
+	{
+		destroy();
+		return false;
+	}
+
+	return true;
+}
+
+void GraphicsContext::destroy()
+{
+	if (window)
+	{
+		glfwDestroyWindow(window);
+		glfwTerminate();
+		window = nullptr;
+	}
+
+	if (context && backend == ContextBackend::EglSurfaceless)
+	{
+		GetFunction<EglMakeCurrent>(library, "eglMakeCurrent")(display, nullptr, nullptr, nullptr);
+		GetFunction<EglDestroyContext>(library, "eglDestroyContext")(display, context);
+	}
+
+	if (display)
+		GetFunction<EglTerminate>(library, "eglTerminate")(display);
+
+	if (context && backend == ContextBackend::OSMesa)
+		GetFunction<OSMesaDestroyContext>(library, "OSMesaDestroyContext")(context);
+
+	// Mesa keeps thread exit handlers in libEGL, unloading it would leave them dangling
+	if (backend != ContextBackend::EglSurfaceless)
+		CloseLibrary(library);
+
+	library = nullptr;
+	display = nullptr;
+	context = nullptr;
+	osmesa_buffer.clear();
+}
+
+void GraphicsContext::swapBuffers()
+{
+	if (window)
+		glfwSwapBuffers(window);
+}
+
+ContextBackend GraphicsContext::getBackend() const
+{
+	return backend;
+}
+
+bool GraphicsContext::isHeadless() const
+{
+	return backend != ContextBackend::Window;
+}
+
+GLFWwindow* GraphicsContext::getWindow() const
+{
+	return window;
+}
+
+bool GraphicsContext::createWindow(const glm::ivec2& size, const char* title)
+{
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, GL_MAJOR);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, GL_MINOR);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+	window = glfwCreateWindow(size.x, size.y, title, NULL, NULL);
+
+	if (window == NULL)
+	{
+		std::cout << "Failed to create GLFW window\n";
+		glfwTerminate();
+		return false;
+	}
+	glfwMakeContextCurrent(window);
+
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool GraphicsContext::createEgl()
+{
+	library = OpenLibrary({ "libEGL.so.1", "libEGL.so" });
+
+	if (!library)
+	{
+		std::cout << "Failed to load libEGL\n";
+		return false;
+	}
+
+	egl_get_proc_address = GetFunction<EglGetProcAddress>(library, "eglGetProcAddress");
+
+	// Surfaceless needs no window system, the default display is the fallback for other EGL vendors
+	auto get_platform_display = reinterpret_cast<EglGetPlatformDisplayExt>(egl_get_proc_address("eglGetPlatformDisplayEXT"));
+
+	if (get_platform_display)
+		display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, nullptr, nullptr);
+
+	if (!display)
+		display = GetFunction<EglGetDisplay>(library, "eglGetDisplay")(nullptr);
+
+	EGLint major, minor;
+
+	if (!display || !GetFunction<EglInitialize>(library, "eglInitialize")(display, &major, &minor))
+	{
+		std::cout << "Failed to initialize EGL display\n";
+		display = nullptr;
+		return false;
+	}
+
+	GetFunction<EglBindApi>(library, "eglBindAPI")(EGL_OPENGL_API);
+
+	// Only the context is created, there are no surfaces (EGL_KHR_surfaceless_context)
+	const EGLint config_attributes[] { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+	void*  config = nullptr;
+	EGLint config_count = 0;
+	GetFunction<EglChooseConfig>(library, "eglChooseConfig")(display, config_attributes, &config, 1, &config_count);
+
+	const EGLint context_attributes[]
+	{
+		EGL_CONTEXT_MAJOR_VERSION, GL_MAJOR,
+		EGL_CONTEXT_MINOR_VERSION, GL_MINOR,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	context = GetFunction<EglCreateContext>(library, "eglCreateContext")(display, config_count > 0 ? config : nullptr, nullptr, context_attributes);
+
+	if (!context || !GetFunction<EglMakeCurrent>(library, "eglMakeCurrent")(display, nullptr, nullptr, context))
+	{
+		std::cout << "Failed to create EGL GL " << GL_MAJOR << '.' << GL_MINOR << " core context\n";
+		return false;
+	}
+
+	if (!gladLoadGLLoader((GLADloadproc)LoadEglFunction))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool GraphicsContext::createOSMesa(const glm::ivec2& size)
+{
+	library = OpenLibrary({ "libOSMesa.so.8", "libOSMesa.so.6", "libOSMesa.so" });
+
+	if (!library)
+	{
+		std::cout << "Failed to load libOSMesa\n";
+		return false;
+	}
+
+	osmesa_get_proc_address = GetFunction<OSMesaGetProcAddress>(library, "OSMesaGetProcAddress");
+
+	const int attributes[]
+	{
+		OSMESA_FORMAT, OSMESA_RGBA,
+		OSMESA_DEPTH_BITS, 0,
+		OSMESA_PROFILE, OSMESA_CORE_PROFILE,
+		OSMESA_CONTEXT_MAJOR_VERSION, GL_MAJOR,
+		OSMESA_CONTEXT_MINOR_VERSION, GL_MINOR,
+		0
+	};
+	auto create_context = GetFunction<OSMesaCreateContextAttribs>(library, "OSMesaCreateContextAttribs");
+
+	if (create_context)
+		context = create_context(attributes, nullptr);
+
+	// OSMesa needs a color buffer to be current, drawing still goes to a RenderTarget
+	osmesa_buffer.resize(static_cast<std::size_t>(size.x) * size.y * 4);
+
+	if (!context || !GetFunction<OSMesaMakeCurrent>(library, "OSMesaMakeCurrent")(context, osmesa_buffer.data(), GL_UNSIGNED_BYTE, size.x, size.y))
+	{
+		std::cout << "Failed to create OSMesa GL " << GL_MAJOR << '.' << GL_MINOR << " core context\n";
+		return false;
+	}
+
+	if (!gladLoadGLLoader((GLADloadproc)LoadOSMesaFunction))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		return false;
+	}
+
+	return true;
+}
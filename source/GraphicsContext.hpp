@@ -0,0 +1,59 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+
+#include <string_view>
+#include <vector>
+
+// Where the GL context comes from. The headless ones need no display and no GPU: with Mesa they run on
+// llvmpipe, which reports GL 4.5, so shaders need MESA_GL_VERSION_OVERRIDE=4.6 MESA_GLSL_VERSION_OVERRIDE=460
+enum class ContextBackend
+{
+	Window,         // GLFW window, the default framebuffer is on screen
+	EglSurfaceless, // EGL_MESA_platform_surfaceless, no framebuffer at all
+	OSMesa,         // Mesa's off-screen renderer into client memory
+	Null            // NullGL, nothing is drawn. For measuring the CPU side
+};
+
+// Creates a GL 4.6 core context on the chosen backend and loads the GL functions through glad.
+// EGL and OSMesa are loaded at run time, so they are not build dependencies. Headless contexts
+// draw into a RenderTarget
+class GraphicsContext
+{
+public:
+	GraphicsContext();
+	GraphicsContext(const GraphicsContext&) = delete;
+	GraphicsContext& operator = (const GraphicsContext&) = delete;
+	~GraphicsContext();
+
+	// "window", "egl", "osmesa" or "null"
+	static bool parseBackend(std::string_view name, ContextBackend& backend);
+
+	bool create(ContextBackend backend, const glm::ivec2& size, const char* title);
+	void destroy();
+
+	// Presents the window, headless contexts have nothing to present
+	void swapBuffers();
+
+	ContextBackend getBackend() const;
+	bool           isHeadless() const;
+	// nullptr for headless contexts
+	GLFWwindow*    getWindow() const;
+
+private:
+	bool createWindow(const glm::ivec2& size, const char* title);
+	bool createEgl();
+	bool createOSMesa(const glm::ivec2& size);
+
+	ContextBackend backend;
+	GLFWwindow*    window;
+
+	void* library; // libEGL or libOSMesa
+	void* display;
+	void* context;
+
+	std::vector<unsigned char> osmesa_buffer;
+};
@@ -0,0 +1,340 @@
+#include "ImageCache.hpp"
+
+#include "stb_image.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	const char          MAGIC[8]    { 'O', 'G', 'E', 'I', 'M', 'G', '0', '1' };
+	constexpr std::size_t DATA_ALIGN = 64;
+
+	struct EntryHeader
+	{
+		char          magic[8];
+		std::uint64_t source_size;
+		std::int64_t  source_time;
+		std::uint32_t width;
+		std::uint32_t height;
+		std::uint32_t channels;
+		std::uint32_t variant;
+		std::uint32_t path_length;
+		std::uint32_t data_offset;
+	};
+
+	bool ReadSourceStamp(const std::string& file_path, std::uint64_t& size, std::int64_t& time)
+	{
+		std::error_code error;
+
+		size = std::filesystem::file_size(file_path, error);
+		if (error) return false;
+
+		time = std::filesystem::last_write_time(file_path, error).time_since_epoch().count();
+		return !error;
+	}
+
+	bool MapFile(const std::string& path, void*& mapping, std::size_t& size, void*& handle)
+	{
+#ifdef _WIN32
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) return false;
+
+		LARGE_INTEGER file_size;
+		GetFileSizeEx(file, &file_size);
+
+		HANDLE file_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		CloseHandle(file);
+		if (!file_mapping) return false;
+
+		mapping = MapViewOfFile(file_mapping, FILE_MAP_READ, 0, 0, 0);
+		if (!mapping)
+		{
+			CloseHandle(file_mapping);
+			return false;
+		}
+
+		size   = static_cast<std::size_t>(file_size.QuadPart);
+		handle = file_mapping;
+		return true;
+#else
+		int file = open(path.c_str(), O_RDONLY);
+		if (file < 0) return false;
+
+		struct stat info;
+		if (fstat(file, &info) != 0 || info.st_size == 0)
+		{
+			close(file);
+			return false;
+		}
+
+		void* view = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		close(file);
+		if (view == MAP_FAILED) return false;
+
+		mapping = view;
+		size    = static_cast<std::size_t>(info.st_size);
+		handle  = nullptr;
+		return true;
+#endif
+	}
+
+	void UnmapFile(void* mapping, std::size_t size, void* handle)
+	{
+#ifdef _WIN32
+		(void)size;
+		UnmapViewOfFile(mapping);
+		CloseHandle(handle);
+#else
+		(void)handle;
+		munmap(mapping, size);
+#endif
+	}
+}
+
+DecodedImage::DecodedImage():
+	pixels(nullptr), width(0), height(0), channels(0),
+	mapping(nullptr), mapping_size(0), mapping_handle(nullptr)
+{
+}
+
+DecodedImage::DecodedImage(DecodedImage&& other) noexcept:
+	DecodedImage()
+{
+	*this = std::move(other);
+}
+
+DecodedImage& DecodedImage::operator = (DecodedImage&& other) noexcept
+{
+	if (this != &other)
+	{
+		release();
+
+		std::swap(pixels,         other.pixels);
+		std::swap(width,          other.width);
+		std::swap(height,         other.height);
+		std::swap(channels,       other.channels);
+		std::swap(mapping,        other.mapping);
+		std::swap(mapping_size,   other.mapping_size);
+		std::swap(mapping_handle, other.mapping_handle);
+		std::swap(storage,        other.storage);
+	}
+	return *this;
+}
+
+DecodedImage::~DecodedImage()
+{
+	release();
+}
+
+bool DecodedImage::loadFromFile(const std::string& file_path, int desired_channels, ImageTransform transform)
+{
+	release();
+
+	int file_channels;
+	pixels = stbi_load(file_path.c_str(), &width, &height, &file_channels, desired_channels);
+
+	if (!pixels)
+	{
+		width = height = 0;
+		return false;
+	}
+
+	channels = desired_channels ? desired_channels : file_channels;
+
+	if (transform)
+		transform(pixels, width, height, channels);
+
+	return true;
+}
+
+void DecodedImage::assign(std::vector<unsigned char>&& new_pixels, int new_width, int new_height, int new_channels)
+{
+	release();
+
+	storage  = std::move(new_pixels);
+	pixels   = storage.data();
+	width    = new_width;
+	height   = new_height;
+	channels = new_channels;
+}
+
+const unsigned char* DecodedImage::getPixels() const
+{
+	return pixels;
+}
+
+int DecodedImage::getWidth() const
+{
+	return width;
+}
+
+int DecodedImage::getHeight() const
+{
+	return height;
+}
+
+int DecodedImage::getChannels() const
+{
+	return channels;
+}
+
+bool DecodedImage::isMapped() const
+{
+	return mapping != nullptr;
+}
+
+void DecodedImage::release()
+{
+	if (mapping)
+		UnmapFile(mapping, mapping_size, mapping_handle);
+	else if (pixels && storage.empty())
+		stbi_image_free(pixels);
+
+	storage.clear();
+	storage.shrink_to_fit();
+
+	pixels         = nullptr;
+	mapping        = nullptr;
+	mapping_size   = 0;
+	mapping_handle = nullptr;
+	width = height = channels = 0;
+}
+
+ImageCache::ImageCache(const std::string& directory):
+	directory(directory)
+{
+	if (!this->directory.empty() && this->directory.back() != '/' && this->directory.back() != '\\')
+		this->directory += '/';
+}
+
+bool ImageCache::load(const std::string& file_path, DecodedImage& image, int desired_channels, std::uint32_t variant, Transform transform)
+{
+	image.release();
+
+	std::uint64_t source_size = 0;
+	std::int64_t  source_time = 0;
+	const bool has_stamp = ReadSourceStamp(file_path, source_size, source_time);
+
+	const std::string entry_path = getEntryPath(file_path, desired_channels, variant);
+
+	// Warm start: the entry is valid only for the very same source file
+	if (has_stamp && MapFile(entry_path, image.mapping, image.mapping_size, image.mapping_handle))
+	{
+		const auto* header = static_cast<const EntryHeader*>(image.mapping);
+		const auto* bytes  = static_cast<const unsigned char*>(image.mapping);
+
+		const bool is_valid =
+			image.mapping_size >= sizeof(EntryHeader) &&
+			std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0 &&
+			header->source_size == source_size &&
+			header->source_time == source_time &&
+			header->variant     == variant &&
+			header->path_length == file_path.size() &&
+			sizeof(EntryHeader) + header->path_length <= image.mapping_size &&
+			std::memcmp(bytes + sizeof(EntryHeader), file_path.data(), file_path.size()) == 0 &&
+			header->data_offset + std::size_t(header->width) * header->height * header->channels <= image.mapping_size;
+
+		if (is_valid)
+		{
+			image.pixels   = const_cast<unsigned char*>(bytes + header->data_offset);
+			image.width    = header->width;
+			image.height   = header->height;
+			image.channels = header->channels;
+			return true;
+		}
+		image.release();
+	}
+
+	// Cold start: decode exactly as before and store the result for the next run
+	if (!image.loadFromFile(file_path, desired_channels, transform))
+		return false;
+
+	const unsigned char* pixels = image.pixels;
+	const int width    = image.width;
+	const int height   = image.height;
+	const int channels = image.channels;
+
+	if (!has_stamp)
+		return true;
+
+	EntryHeader header {};
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.source_size = source_size;
+	header.source_time = source_time;
+	header.width       = width;
+	header.height      = height;
+	header.channels    = channels;
+	header.variant     = variant;
+	header.path_length = static_cast<std::uint32_t>(file_path.size());
+	header.data_offset = static_cast<std::uint32_t>((sizeof(EntryHeader) + file_path.size() + DATA_ALIGN - 1) / DATA_ALIGN * DATA_ALIGN);
+
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+
+	// Written aside and renamed, so a crash never leaves a half written entry under the real name
+	const std::string temporary_path = entry_path + ".tmp";
+	{
+		std::ofstream file(temporary_path, std::ios::binary);
+
+		if (!file.is_open())
+			return true; // The cache is optional, the image is loaded anyway
+
+		const std::size_t padding = header.data_offset - sizeof(EntryHeader) - file_path.size();
+		const char zeros[DATA_ALIGN] {};
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(file_path.data(), file_path.size());
+		file.write(zeros, padding);
+		file.write(reinterpret_cast<const char*>(pixels), std::size_t(width) * height * channels);
+
+		if (!file)
+		{
+			file.close();
+			std::filesystem::remove(temporary_path, error);
+			return true;
+		}
+	}
+
+	std::filesystem::rename(temporary_path, entry_path, error);
+
+	if (error)
+	{
+		std::cout << "Failed to store " << file_path << " in the image cache\n";
+		std::filesystem::remove(temporary_path, error);
+	}
+	return true;
+}
+
+std::string ImageCache::getEntryPath(const std::string& file_path, int desired_channels, std::uint32_t variant) const
+{
+	// FNV-1a of the path, the path itself is checked against the header
+	std::uint64_t hash = 14695981039346656037ull;
+
+	for (char character : file_path)
+	{
+		hash ^= static_cast<unsigned char>(character);
+		hash *= 1099511628211ull;
+	}
+
+	char name[64];
+	std::snprintf(name, sizeof(name), "%016llx_%d_%u.raw", static_cast<unsigned long long>(hash), desired_channels, variant);
+
+	return directory + name;
+}
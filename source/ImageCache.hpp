@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Processing applied to freshly decoded pixels in place, e.g. PremultiplyAlpha
+using ImageTransform = void(*)(unsigned char* pixels, int width, int height, int channels);
+
+// Decoded pixels, either owned (fresh decode or a processed copy) or viewed through a read-only file mapping (cache hit)
+class DecodedImage
+{
+public:
+	DecodedImage();
+	DecodedImage(const DecodedImage&) = delete;
+	DecodedImage& operator = (const DecodedImage&) = delete;
+	DecodedImage(DecodedImage&& other) noexcept;
+	DecodedImage& operator = (DecodedImage&& other) noexcept;
+	~DecodedImage();
+
+	// Plain decode without any cache
+	bool loadFromFile(const std::string& file_path, int desired_channels = 0, ImageTransform transform = nullptr);
+	// Takes over pixels produced by processing that changes the size, e.g. ExtrudeTiles
+	void assign(std::vector<unsigned char>&& new_pixels, int new_width, int new_height, int new_channels);
+
+	const unsigned char* getPixels()   const;
+	int                  getWidth()    const;
+	int                  getHeight()   const;
+	int                  getChannels() const;
+	bool                 isMapped()    const;
+
+private:
+	friend class ImageCache;
+
+	void release();
+
+	unsigned char* pixels;
+	int            width;
+	int            height;
+	int            channels;
+
+	// Mapping of the cache file, pixels point inside it
+	void*       mapping;
+	std::size_t mapping_size;
+	void*       mapping_handle; // Windows only
+
+	// Pixels given through assign()
+	std::vector<unsigned char> storage;
+};
+
+// Disk cache of decoded images for fast warm starts. Entries are raw pixels behind a small header,
+// keyed by the source path, size and modification time, so a changed source is decoded again.
+// A variant number separates differently processed copies of one source (e.g. premultiplied).
+// Safe to use from several threads as long as they don't load the same file at once.
+class ImageCache
+{
+public:
+	using Transform = ImageTransform;
+
+	explicit ImageCache(const std::string& directory = "cache/images/");
+
+	// desired_channels is 0 (as stored in the file), 3 or 4. The transform runs only on a cache miss
+	bool load(const std::string& file_path, DecodedImage& image, int desired_channels = 0,
+		      std::uint32_t variant = 0, Transform transform = nullptr);
+
+private:
+	std::string getEntryPath(const std::string& file_path, int desired_channels, std::uint32_t variant) const;
+
+	std::string directory;
+};
@@ -0,0 +1,139 @@
+#include "ImageOperations.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IMAGE_OPERATIONS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	// Exact round(value / 255) for value in [0, 255 * 255]
+	inline unsigned DivideBy255(unsigned value)
+	{
+		value += 128;
+		return (value + (value >> 8)) >> 8;
+	}
+}
+
+void PremultiplyAlpha(unsigned char* rgba_pixels, std::size_t pixel_count)
+{
+	std::size_t i = 0;
+
+#ifdef IMAGE_OPERATIONS_SSE2
+	const __m128i zero       = _mm_setzero_si128();
+	const __m128i rounding   = _mm_set1_epi16(128);
+	const __m128i alpha_mask = _mm_set_epi32(0xFF000000, 0xFF000000, 0xFF000000, 0xFF000000);
+
+	// 4 pixels per step, each half widened to 16 bits
+	for (; i + 4 <= pixel_count; i += 4)
+	{
+		__m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba_pixels + i * 4));
+
+		__m128i low  = _mm_unpacklo_epi8(pixels, zero);
+		__m128i high = _mm_unpackhi_epi8(pixels, zero);
+
+		// Broadcast alpha of every pixel over its four lanes
+		__m128i low_alpha  = _mm_shufflehi_epi16(_mm_shufflelo_epi16(low,  _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+		__m128i high_alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(high, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+
+		low  = _mm_add_epi16(_mm_mullo_epi16(low,  low_alpha),  rounding);
+		high = _mm_add_epi16(_mm_mullo_epi16(high, high_alpha), rounding);
+
+		low  = _mm_srli_epi16(_mm_add_epi16(low,  _mm_srli_epi16(low,  8)), 8);
+		high = _mm_srli_epi16(_mm_add_epi16(high, _mm_srli_epi16(high, 8)), 8);
+
+		__m128i result = _mm_packus_epi16(low, high);
+
+		// Alpha itself stays untouched
+		result = _mm_or_si128(_mm_andnot_si128(alpha_mask, result), _mm_and_si128(alpha_mask, pixels));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(rgba_pixels + i * 4), result);
+	}
+#endif
+
+	for (; i < pixel_count; ++i)
+	{
+		unsigned char* pixel = rgba_pixels + i * 4;
+		const unsigned alpha = pixel[3];
+
+		pixel[0] = static_cast<unsigned char>(DivideBy255(pixel[0] * alpha));
+		pixel[1] = static_cast<unsigned char>(DivideBy255(pixel[1] * alpha));
+		pixel[2] = static_cast<unsigned char>(DivideBy255(pixel[2] * alpha));
+	}
+}
+
+void PremultiplyAlpha(unsigned char* pixels, int width, int height, int channels)
+{
+	if (channels == 4)
+		PremultiplyAlpha(pixels, std::size_t(width) * height);
+}
+
+void GetExtrudedSize(int width, int height, const TileLayout& layout, int& extruded_width, int& extruded_height)
+{
+	if (layout.tile_width <= 0 || layout.tile_height <= 0)
+	{
+		extruded_width  = width;
+		extruded_height = height;
+		return;
+	}
+
+	extruded_width  = width  / layout.tile_width  * (layout.tile_width  + 2 * layout.border);
+	extruded_height = height / layout.tile_height * (layout.tile_height + 2 * layout.border);
+}
+
+int GetProtectedLevelCount(const TileLayout& layout)
+{
+	int level_count = 1;
+
+	// Level n halves the cells n times, the border and both tile sides must stay whole texels
+	for (int step = 2; step <= layout.border; step *= 2, ++level_count)
+		if (layout.border % step || layout.tile_width % step || layout.tile_height % step)
+			break;
+
+	return level_count;
+}
+
+std::vector<unsigned char> ExtrudeTiles(const unsigned char* pixels, int width, int height, int channels, const TileLayout& layout)
+{
+	int extruded_width, extruded_height;
+	GetExtrudedSize(width, height, layout, extruded_width, extruded_height);
+
+	std::vector<unsigned char> result(std::size_t(extruded_width) * extruded_height * channels);
+
+	if (layout.tile_width <= 0 || layout.tile_height <= 0)
+	{
+		std::memcpy(result.data(), pixels, result.size());
+		return result;
+	}
+
+	const int column_count = width  / layout.tile_width;
+	const int row_count    = height / layout.tile_height;
+	const int cell_width   = layout.tile_width  + 2 * layout.border;
+	const int cell_height  = layout.tile_height + 2 * layout.border;
+
+	const std::size_t tile_row_size = std::size_t(layout.tile_width) * channels;
+
+	for (int row = 0; row < row_count; ++row)
+		for (int column = 0; column < column_count; ++column)
+			for (int y = 0; y < cell_height; ++y)
+			{
+				// Rows above and below the tile repeat its first and last row
+				const int source_y = row * layout.tile_height + std::clamp(y - layout.border, 0, layout.tile_height - 1);
+
+				const unsigned char* source      = pixels + (std::size_t(source_y) * width + std::size_t(column) * layout.tile_width) * channels;
+				unsigned char*       destination = result.data() + ((std::size_t(row) * cell_height + y) * extruded_width + std::size_t(column) * cell_width) * channels;
+
+				for (int x = 0; x < layout.border; ++x)
+				{
+					std::memcpy(destination + std::size_t(x) * channels, source, channels);
+					std::memcpy(destination + std::size_t(layout.border + layout.tile_width + x) * channels, source + tile_row_size - channels, channels);
+				}
+
+				std::memcpy(destination + std::size_t(layout.border) * channels, source, tile_row_size);
+			}
+
+	return result;
+}
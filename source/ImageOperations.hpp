@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Multiplies color by alpha in place. Vectorized with SSE2 where available, the scalar tail gives identical results
+void PremultiplyAlpha(unsigned char* rgba_pixels, std::size_t pixel_count);
+
+// Same, in the shape of an image transform (see ImageCache). Images without alpha are left as is
+void PremultiplyAlpha(unsigned char* pixels, int width, int height, int channels);
+
+// Tileset grid for extrusion. Every tile gets a border of its own edge texels repeated, so filtering
+// and the first mip levels never sample the neighbouring tile (see GetProtectedLevelCount).
+// A zero border means the tileset is used as is
+struct TileLayout
+{
+	int tile_width  = 0;
+	int tile_height = 0;
+	int border      = 0;
+};
+
+// Size of the extruded tileset, tiles not wholly inside the image are dropped
+void GetExtrudedSize(int width, int height, const TileLayout& layout, int& extruded_width, int& extruded_height);
+
+// Mip levels the border keeps free of seams: in each of them the cells start on a texel and keep at least one
+// texel of border. A 2 px border gives 2 levels, smaller levels blend neighbouring tiles. At least 1
+int GetProtectedLevelCount(const TileLayout& layout);
+
+// Tiles keep their row-major order, each one moves to a cell of (tile size + 2 * border) with the tile at (border, border)
+std::vector<unsigned char> ExtrudeTiles(const unsigned char* pixels, int width, int height, int channels, const TileLayout& layout);
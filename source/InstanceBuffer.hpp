@@ -0,0 +1,229 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include "GLState.hpp"
+#include "Texture.hpp"
+#include "Color.hpp"
+#include "ShaderProgram.hpp"
+#include "RenderQueue.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+// One per instance vertex attribute, its location is its place in the list given to InstanceBuffer
+struct InstanceAttribute
+{
+	GLint       size;   // Components
+	GLenum      type;   // GL_INT and GL_UNSIGNED_INT stay integers in the shader
+	std::size_t offset; // Into the instance struct
+};
+
+// Tint as the batch shaders take it: premultiplied when textures are, as in Sprite
+inline glm::vec4 GetInstanceColor(const Color& color)
+{
+	if (Texture::isPremultipliedAlpha())
+		return glm::vec4(glm::vec3(color) * color.a, color.a);
+
+	return color;
+}
+
+// CPU array of instances and the GL buffer drawing them as quads built from gl_VertexID (see SpriteBatch).
+// Editing an instance only widens the dirty range, upload() sends that range in one call,
+// so code that edits instances needs no GL at all
+template <typename Instance>
+class InstanceBuffer
+{
+public:
+	using InstanceId = std::uint32_t;
+
+	explicit InstanceBuffer(std::initializer_list<InstanceAttribute> attributes):
+		VAO(0), VBO(0),
+		buffer_capacity(0),
+		dirty_begin(0),
+		dirty_end(0)
+	{
+		GLuint location = 0;
+
+		if (GLState::hasDirectStateAccess())
+		{
+			glCreateVertexArrays(1, &VAO);
+			glCreateBuffers(1, &VBO);
+
+			glVertexArrayVertexBuffer(VAO, 0, VBO, 0, sizeof(Instance));
+			glVertexArrayBindingDivisor(VAO, 0, 1);
+
+			for (const auto& attribute : attributes)
+			{
+				if (isInteger(attribute.type))
+					glVertexArrayAttribIFormat(VAO, location, attribute.size, attribute.type, static_cast<GLuint>(attribute.offset));
+				else
+					glVertexArrayAttribFormat(VAO, location, attribute.size, attribute.type, GL_FALSE, static_cast<GLuint>(attribute.offset));
+
+				glVertexArrayAttribBinding(VAO, location, 0);
+				glEnableVertexArrayAttrib(VAO, location++);
+			}
+			return;
+		}
+
+		glGenVertexArrays(1, &VAO);
+		glGenBuffers(1, &VBO);
+
+		GLState::bindVertexArray(VAO);
+		GLState::bindBuffer(GL_ARRAY_BUFFER, VBO);
+
+		for (const auto& attribute : attributes)
+		{
+			if (isInteger(attribute.type))
+				glVertexAttribIPointer(location, attribute.size, attribute.type, sizeof(Instance), (void*)attribute.offset);
+			else
+				glVertexAttribPointer(location, attribute.size, attribute.type, GL_FALSE, sizeof(Instance), (void*)attribute.offset);
+
+			glVertexAttribDivisor(location, 1);
+			glEnableVertexAttribArray(location++);
+		}
+
+		if (GLState::unbind_after_use)
+			GLState::bindVertexArray(0);
+	}
+
+	InstanceBuffer(const InstanceBuffer&) = delete;
+	InstanceBuffer& operator = (const InstanceBuffer&) = delete;
+
+	~InstanceBuffer()
+	{
+		glDeleteVertexArrays(1, &VAO);
+		glDeleteBuffers(1, &VBO);
+
+		GLState::onVertexArrayDeleted(VAO);
+		GLState::onBuffersDeleted(1, &VBO);
+	}
+
+	// Instances live until clear(), their ids are indices
+	InstanceId add()
+	{
+		const auto id = static_cast<InstanceId>(instances.size());
+		instances.emplace_back();
+		markDirty(id);
+
+		return id;
+	}
+
+	void clear()
+	{
+		instances.clear();
+		dirty_begin = dirty_end = 0;
+	}
+
+	// The instance goes up with the next upload
+	Instance& edit(InstanceId id)
+	{
+		markDirty(id);
+		return instances[id];
+	}
+
+	const Instance& get(InstanceId id) const
+	{
+		return instances[id];
+	}
+
+	std::size_t size() const
+	{
+		return instances.size();
+	}
+
+	// Sends the instances changed since the last upload. GL thread only
+	void upload()
+	{
+		if (instances.size() > buffer_capacity)
+		{
+			// Grows by half again, the whole array goes up with the new storage
+			buffer_capacity = std::max(instances.size(), buffer_capacity + buffer_capacity / 2);
+
+			if (GLState::hasDirectStateAccess())
+			{
+				glNamedBufferData(VBO, buffer_capacity * sizeof(Instance), nullptr, GL_DYNAMIC_DRAW);
+			}
+			else
+			{
+				GLState::bindBuffer(GL_ARRAY_BUFFER, VBO);
+				glBufferData(GL_ARRAY_BUFFER, buffer_capacity * sizeof(Instance), nullptr, GL_DYNAMIC_DRAW);
+			}
+
+			// Storage only, the bytes are counted by the uploadBuffer below
+			GLState::onUpload(0);
+
+			dirty_begin = 0;
+			dirty_end   = instances.size();
+		}
+
+		dirty_end = std::min(dirty_end, instances.size());
+
+		if (dirty_begin < dirty_end)
+			GLState::uploadBuffer(GL_ARRAY_BUFFER, VBO, dirty_begin * sizeof(Instance),
+			                      (dirty_end - dirty_begin) * sizeof(Instance), instances.data() + dirty_begin);
+
+		dirty_begin = dirty_end = 0;
+	}
+
+	void submit(RenderQueue& queue, ShaderProgram* shader, Texture* texture, std::uint8_t layer)
+	{
+		RenderCommand command;
+		command.key     = RenderQueue::makeKey(layer, shader->getNativeHandle(), texture->getNativeHandle(), 0);
+		command.shader  = shader;
+		command.texture = texture;
+		command.object  = this;
+		command.draw    = [](void* object, ShaderProgram*)
+		{
+			static_cast<InstanceBuffer*>(object)->draw();
+		};
+		queue.submit(command);
+	}
+
+	// Uploads and issues the draw call, the shader and the texture must be bound already
+	void draw()
+	{
+		if (instances.empty())
+			return;
+
+		upload();
+
+		GLState::bindVertexArray(VAO);
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(instances.size()));
+		GLState::onDraw(2 * instances.size());
+
+		if (GLState::unbind_after_use)
+			GLState::bindVertexArray(0);
+	}
+
+private:
+	static bool isInteger(GLenum type)
+	{
+		return type == GL_INT || type == GL_UNSIGNED_INT;
+	}
+
+	void markDirty(InstanceId id)
+	{
+		if (dirty_begin == dirty_end)
+		{
+			dirty_begin = id;
+			dirty_end   = id + 1;
+			return;
+		}
+
+		dirty_begin = std::min<std::size_t>(dirty_begin, id);
+		dirty_end   = std::max<std::size_t>(dirty_end, id + 1);
+	}
+
+	std::vector<Instance> instances;
+
+	GLuint      VAO, VBO;
+	std::size_t buffer_capacity; // Instances the GL buffer holds
+	std::size_t dirty_begin;
+	std::size_t dirty_end;
+};
@@ -0,0 +1,236 @@
+#include "Ktx2.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <iostream>
+
+namespace
+{
+	const unsigned char KTX2_IDENTIFIER[12] { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	constexpr std::size_t HEADER_SIZE      = 80;
+	constexpr std::size_t LEVEL_INDEX_SIZE = 24;
+
+	// Vulkan format numbers used by the container
+	constexpr std::uint32_t VK_FORMAT_R8G8B8A8_UNORM      = 37;
+	constexpr std::uint32_t VK_FORMAT_BC1_RGBA_UNORM_BLOCK = 133;
+	constexpr std::uint32_t VK_FORMAT_BC7_UNORM_BLOCK     = 145;
+
+	std::uint32_t ReadU32(const unsigned char* bytes)
+	{
+		return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (std::uint32_t(bytes[3]) << 24);
+	}
+
+	std::uint64_t ReadU64(const unsigned char* bytes)
+	{
+		return ReadU32(bytes) | (std::uint64_t(ReadU32(bytes + 4)) << 32);
+	}
+
+	void WriteU32(std::vector<unsigned char>& output, std::uint32_t value)
+	{
+		for (int i = 0; i < 4; ++i)
+			output.push_back((value >> (i * 8)) & 0xFF);
+	}
+
+	void WriteU64(std::vector<unsigned char>& output, std::uint64_t value)
+	{
+		WriteU32(output, value & 0xFFFFFFFF);
+		WriteU32(output, value >> 32);
+	}
+
+	void PutU64(std::vector<unsigned char>& output, std::size_t position, std::uint64_t value)
+	{
+		for (int i = 0; i < 8; ++i)
+			output[position + i] = (value >> (i * 8)) & 0xFF;
+	}
+
+	// Basic data format descriptor, required by the specification for every file
+	constexpr std::uint32_t KHR_DF_FLAG_ALPHA_PREMULTIPLIED = 1;
+
+	std::vector<unsigned char> BuildDataFormatDescriptor(BlockFormat format, bool premultiplied)
+	{
+		std::vector<unsigned char> block;
+
+		const bool     compressed   = format != BlockFormat::RGBA8;
+		const unsigned sample_count = compressed ? 1 : 4;
+
+		WriteU32(block, 0);                                 // vendor and descriptor type
+		WriteU32(block, 2 | ((24 + 16 * sample_count) << 16)); // version 2, block size
+
+		const std::uint32_t color_model = format == BlockFormat::BC1 ? 128 : format == BlockFormat::BC7 ? 134 : 1;
+		const std::uint32_t flags = premultiplied ? KHR_DF_FLAG_ALPHA_PREMULTIPLIED : 0;
+		WriteU32(block, color_model | (1 << 8) | (1 << 16) | (flags << 24)); // BT.709 primaries, linear transfer
+
+		WriteU32(block, compressed ? (3 | (3 << 8)) : 0);  // texel block dimensions minus one
+		WriteU32(block, format == BlockFormat::BC1 ? 8 : format == BlockFormat::BC7 ? 16 : 4);
+		WriteU32(block, 0);
+
+		if (compressed)
+		{
+			const std::uint32_t bit_length = (format == BlockFormat::BC1 ? 64 : 128) - 1;
+			const std::uint32_t channel    = format == BlockFormat::BC1 ? 1 : 0; // BC1 alpha-present, BC7 color
+
+			WriteU32(block, (bit_length << 16) | (channel << 24));
+			WriteU32(block, 0);
+			WriteU32(block, 0);
+			WriteU32(block, 0xFFFFFFFF);
+		}
+		else
+		{
+			const std::uint32_t channels[4] { 0, 1, 2, 15 }; // R, G, B, A
+
+			for (std::uint32_t i = 0; i < 4; ++i)
+			{
+				WriteU32(block, (i * 8) | (7 << 16) | (channels[i] << 24));
+				WriteU32(block, 0);
+				WriteU32(block, 0);
+				WriteU32(block, 255);
+			}
+		}
+
+		std::vector<unsigned char> descriptor;
+		WriteU32(descriptor, static_cast<std::uint32_t>(block.size() + 4));
+		descriptor.insert(descriptor.end(), block.begin(), block.end());
+
+		return descriptor;
+	}
+}
+
+bool ParseKtx2(std::vector<unsigned char> file_data, Ktx2Image& image)
+{
+	if (file_data.size() < HEADER_SIZE || std::memcmp(file_data.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0)
+		return false;
+
+	const unsigned char* header = file_data.data();
+
+	const std::uint32_t vk_format   = ReadU32(header + 12);
+	const std::uint32_t width       = ReadU32(header + 20);
+	const std::uint32_t height      = ReadU32(header + 24);
+	const std::uint32_t depth       = ReadU32(header + 28);
+	const std::uint32_t layers      = ReadU32(header + 32);
+	const std::uint32_t faces       = ReadU32(header + 36);
+	const std::uint32_t level_count = std::max<std::uint32_t>(ReadU32(header + 40), 1);
+	const std::uint32_t compression = ReadU32(header + 44);
+	const std::uint32_t dfd_offset  = ReadU32(header + 48);
+	const std::uint32_t dfd_size    = ReadU32(header + 52);
+
+	switch (vk_format)
+	{
+		case VK_FORMAT_R8G8B8A8_UNORM:       image.format = BlockFormat::RGBA8; break;
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK: image.format = BlockFormat::BC1;   break;
+		case VK_FORMAT_BC7_UNORM_BLOCK:      image.format = BlockFormat::BC7;   break;
+		default: return false;
+	}
+
+	if (!width || !height || depth > 1 || layers > 1 || faces != 1 || compression != 0 || level_count > 32)
+		return false;
+
+	if (file_data.size() < HEADER_SIZE + level_count * LEVEL_INDEX_SIZE)
+		return false;
+
+	image.width  = width;
+	image.height = height;
+	image.levels.clear();
+
+	// Flags are the last byte of the third word of the first descriptor block
+	image.premultiplied = dfd_size >= 16 && dfd_offset <= file_data.size() - 16 &&
+		                  (header[dfd_offset + 15] & KHR_DF_FLAG_ALPHA_PREMULTIPLIED) != 0;
+
+	for (std::uint32_t level = 0; level < level_count; ++level)
+	{
+		const unsigned char* index = header + HEADER_SIZE + level * LEVEL_INDEX_SIZE;
+
+		const std::uint64_t offset = ReadU64(index);
+		const std::uint64_t size   = ReadU64(index + 8);
+
+		const unsigned level_width  = std::max(width >> level, 1u);
+		const unsigned level_height = std::max(height >> level, 1u);
+
+		if (offset > file_data.size() || size > file_data.size() - offset || size != GetImageSize(image.format, level_width, level_height))
+			return false;
+
+		image.levels.push_back({ static_cast<std::size_t>(offset), static_cast<std::size_t>(size) });
+	}
+
+	image.data = std::move(file_data);
+	return true;
+}
+
+bool LoadKtx2(const std::string& file_path, Ktx2Image& image)
+{
+	std::ifstream file(file_path, std::ios::binary);
+
+	if (!file.is_open())
+	{
+		std::cout << "Failed to open " + file_path + '\n';
+		return false;
+	}
+
+	std::vector<unsigned char> file_data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	if (!ParseKtx2(std::move(file_data), image))
+	{
+		std::cout << "Unsupported or broken KTX2 file " + file_path + '\n';
+		return false;
+	}
+	return true;
+}
+
+bool SaveKtx2(const std::string& file_path, BlockFormat format, unsigned width, unsigned height, const std::vector<std::vector<unsigned char>>& levels,
+              bool premultiplied)
+{
+	if (levels.empty())
+		return false;
+
+	const std::uint32_t vk_format = format == BlockFormat::BC1 ? VK_FORMAT_BC1_RGBA_UNORM_BLOCK :
+		                            format == BlockFormat::BC7 ? VK_FORMAT_BC7_UNORM_BLOCK : VK_FORMAT_R8G8B8A8_UNORM;
+
+	std::vector<unsigned char> output(KTX2_IDENTIFIER, KTX2_IDENTIFIER + sizeof(KTX2_IDENTIFIER));
+
+	const std::vector<unsigned char> descriptor = BuildDataFormatDescriptor(format, premultiplied);
+	const std::size_t descriptor_offset = HEADER_SIZE + levels.size() * LEVEL_INDEX_SIZE;
+
+	WriteU32(output, vk_format);
+	WriteU32(output, 1);            // type size
+	WriteU32(output, width);
+	WriteU32(output, height);
+	WriteU32(output, 0);            // depth
+	WriteU32(output, 0);            // layers
+	WriteU32(output, 1);            // faces
+	WriteU32(output, static_cast<std::uint32_t>(levels.size()));
+	WriteU32(output, 0);            // supercompression
+	WriteU32(output, static_cast<std::uint32_t>(descriptor_offset));
+	WriteU32(output, static_cast<std::uint32_t>(descriptor.size()));
+	WriteU32(output, 0);            // key/value data
+	WriteU32(output, 0);
+	WriteU64(output, 0);            // supercompression global data
+	WriteU64(output, 0);
+
+	const std::size_t level_index = output.size();
+	output.resize(output.size() + levels.size() * LEVEL_INDEX_SIZE, 0);
+	output.insert(output.end(), descriptor.begin(), descriptor.end());
+
+	// Level data goes from the smallest, each aligned to 16 bytes (a multiple of every block size)
+	for (std::size_t level = levels.size(); level-- > 0;)
+	{
+		output.resize((output.size() + 15) & ~std::size_t(15), 0);
+
+		PutU64(output, level_index + level * LEVEL_INDEX_SIZE,      output.size());
+		PutU64(output, level_index + level * LEVEL_INDEX_SIZE + 8,  levels[level].size());
+		PutU64(output, level_index + level * LEVEL_INDEX_SIZE + 16, levels[level].size());
+
+		output.insert(output.end(), levels[level].begin(), levels[level].end());
+	}
+
+	std::ofstream file(file_path, std::ios::binary);
+
+	if (!file.is_open() || !file.write(reinterpret_cast<const char*>(output.data()), output.size()))
+	{
+		std::cout << "Failed to write " + file_path + '\n';
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "BlockCompression.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Minimal KTX2 container: 2D, single layer and face, no supercompression
+struct Ktx2Image
+{
+	struct Level
+	{
+		std::size_t offset = 0; // Into data
+		std::size_t size   = 0;
+	};
+
+	BlockFormat                format = BlockFormat::RGBA8;
+	unsigned                   width  = 0;
+	unsigned                   height = 0;
+	bool                       premultiplied = false; // Color already multiplied by alpha
+	std::vector<Level>         levels; // The largest first
+	std::vector<unsigned char> data;   // The whole file, levels point into it
+
+	const unsigned char* getLevelData(std::size_t level) const
+	{
+		return data.data() + levels[level].offset;
+	}
+};
+
+// Takes the file contents and validates every offset, so a broken file can't cause reads past the end
+bool ParseKtx2(std::vector<unsigned char> file_data, Ktx2Image& image);
+bool LoadKtx2(const std::string& file_path, Ktx2Image& image);
+// Levels go from the largest, each one already encoded in the format
+bool SaveKtx2(const std::string& file_path, BlockFormat format, unsigned width, unsigned height, const std::vector<std::vector<unsigned char>>& levels,
+              bool premultiplied = false);
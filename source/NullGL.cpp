@@ -0,0 +1,531 @@
+#include "NullGL.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstring>
+#include <map>
+#include <string>
+#include <utility>
+
+static_assert(sizeof(void*) == 8, "NullGL stubs rely on the caller cleaning up the arguments");
+
+namespace
+{
+	constexpr std::size_t MAX_FUNCTIONS = 1024;
+
+	struct Counter
+	{
+		std::uint64_t count = 0;
+		std::uint64_t bytes = 0;
+	};
+
+	struct Uniform
+	{
+		std::string name;
+		GLenum      type;
+	};
+
+	struct Program
+	{
+		std::vector<GLuint>  shaders;
+		std::vector<Uniform> uniforms;
+	};
+
+	bool recording = false;
+
+	// Slots are given out as glad asks for functions, one per name
+	std::map<std::string, std::size_t, std::less<>> slots;
+	std::array<const char*, MAX_FUNCTIONS>          slot_names {};
+	std::array<Counter, MAX_FUNCTIONS>              counters;
+
+	GLuint                                 next_name = 1;
+	std::map<GLuint, std::vector<Uniform>> shader_uniforms;
+	std::map<GLuint, Program>              programs;
+	std::vector<unsigned char>             mapped_memory;
+
+	std::size_t SlotOf(const char* name)
+	{
+		auto found = slots.find(std::string_view(name));
+		return found != slots.end() ? found->second : MAX_FUNCTIONS;
+	}
+
+	void Record(std::size_t slot, std::uint64_t bytes)
+	{
+		if (!recording || slot >= MAX_FUNCTIONS)
+			return;
+
+		counters[slot].count++;
+		counters[slot].bytes += bytes;
+	}
+
+	// Every typed stub looks its slot up once
+#define NULL_GL_RECORD(name, bytes) do { static const std::size_t slot = SlotOf(name); Record(slot, bytes); } while (false)
+
+	template <std::size_t Slot>
+	void* APIENTRY GenericStub()
+	{
+		Record(Slot, 0);
+		return nullptr;
+	}
+
+	template <std::size_t... Slots>
+	constexpr std::array<void*(APIENTRY*)(), sizeof...(Slots)> MakeGenericStubs(std::index_sequence<Slots...>)
+	{
+		return { &GenericStub<Slots>... };
+	}
+
+	const auto generic_stubs = MakeGenericStubs(std::make_index_sequence<MAX_FUNCTIONS>());
+
+	std::size_t PixelSize(GLenum format, GLenum type)
+	{
+		std::size_t channels = 4;
+
+		switch (format)
+		{
+			case GL_RED: case GL_RED_INTEGER:                    channels = 1; break;
+			case GL_RG:  case GL_RG_INTEGER:                     channels = 2; break;
+			case GL_RGB: case GL_BGR: case GL_RGB_INTEGER:       channels = 3; break;
+		}
+
+		switch (type)
+		{
+			case GL_UNSIGNED_SHORT: case GL_SHORT: case GL_HALF_FLOAT: return channels * 2;
+			case GL_UNSIGNED_INT:   case GL_INT:   case GL_FLOAT:      return channels * 4;
+			default:                                                   return channels;
+		}
+	}
+
+	GLenum UniformType(const std::string& type)
+	{
+		static const std::map<std::string, GLenum, std::less<>> types
+		{
+			{ "float", GL_FLOAT }, { "vec2", GL_FLOAT_VEC2 }, { "vec3", GL_FLOAT_VEC3 }, { "vec4", GL_FLOAT_VEC4 },
+			{ "int", GL_INT }, { "mat4", GL_FLOAT_MAT4 }, { "sampler2D", GL_SAMPLER_2D }
+		};
+
+		auto found = types.find(type);
+		return found != types.end() ? found->second : GL_FLOAT;
+	}
+
+	// Plain "uniform type name;" declarations outside of blocks. Both sides of an #ifdef count, drivers would drop the unused ones
+	std::vector<Uniform> ParseUniforms(const std::string& source)
+	{
+		std::vector<Uniform> uniforms;
+		int depth = 0;
+
+		for (std::size_t i = 0; i < source.size(); ++i)
+		{
+			if (source[i] == '{') depth++;
+			if (source[i] == '}') depth--;
+
+			const bool at_word = i == 0 || !(std::isalnum(static_cast<unsigned char>(source[i - 1])) || source[i - 1] == '_');
+
+			if (depth != 0 || !at_word || source.compare(i, 8, "uniform ") != 0)
+				continue;
+
+			const std::size_t end = source.find_first_of(";{", i);
+
+			if (end == std::string::npos || source[end] == '{')
+				continue;
+
+			// The last two words before ';' are the type and the name, array sizes dropped
+			std::string declaration = source.substr(i + 8, end - i - 8);
+			declaration = declaration.substr(0, declaration.find('['));
+
+			const std::size_t name_end   = declaration.find_last_not_of(" \t\r\n") + 1;
+			const std::size_t name_begin = declaration.find_last_of(" \t\r\n", name_end - 1) + 1;
+			const std::size_t type_end   = declaration.find_last_not_of(" \t\r\n", name_begin - 1) + 1;
+			const std::size_t type_begin = declaration.find_last_of(" \t\r\n", type_end - 1) + 1;
+
+			uniforms.push_back({ declaration.substr(name_begin, name_end - name_begin),
+			                     UniformType(declaration.substr(type_begin, type_end - type_begin)) });
+		}
+
+		return uniforms;
+	}
+
+	void GenerateNames(GLsizei count, GLuint* names)
+	{
+		for (GLsizei i = 0; i < count; ++i)
+			names[i] = next_name++;
+	}
+
+	// Queries
+
+	const GLubyte* APIENTRY GetString(GLenum name)
+	{
+		NULL_GL_RECORD("glGetString", 0);
+
+		switch (name)
+		{
+			case GL_VERSION:                  return reinterpret_cast<const GLubyte*>("4.6 NullGL");
+			case GL_SHADING_LANGUAGE_VERSION: return reinterpret_cast<const GLubyte*>("4.60");
+			default:                          return reinterpret_cast<const GLubyte*>("NullGL");
+		}
+	}
+
+	const GLubyte* APIENTRY GetStringi(GLenum, GLuint)
+	{
+		NULL_GL_RECORD("glGetStringi", 0);
+		return reinterpret_cast<const GLubyte*>("GL_ARB_direct_state_access");
+	}
+
+	void APIENTRY GetIntegerv(GLenum name, GLint* data)
+	{
+		NULL_GL_RECORD("glGetIntegerv", 0);
+
+		switch (name)
+		{
+			// glad fails to load when the list of extensions is empty
+			case GL_NUM_EXTENSIONS:                    *data = 1;     break;
+			case GL_MAX_TEXTURE_SIZE:                  *data = 16384; break;
+			case GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS:  *data = 32;    break;
+			case GL_MAX_UNIFORM_BUFFER_BINDINGS:       *data = 36;    break;
+			default:                                   *data = 0;     break;
+		}
+	}
+
+	void APIENTRY GetInteger64v(GLenum, GLint64* data)
+	{
+		NULL_GL_RECORD("glGetInteger64v", 0);
+		*data = 0;
+	}
+
+	void APIENTRY GetQueryObjectiv(GLuint, GLenum, GLint* value)
+	{
+		NULL_GL_RECORD("glGetQueryObjectiv", 0);
+		*value = GL_TRUE;
+	}
+
+	void APIENTRY GetQueryObjectui64v(GLuint, GLenum, GLuint64* value)
+	{
+		NULL_GL_RECORD("glGetQueryObjectui64v", 0);
+		*value = 0;
+	}
+
+	GLenum APIENTRY CheckFramebufferStatus(GLenum)
+	{
+		NULL_GL_RECORD("glCheckFramebufferStatus", 0);
+		return GL_FRAMEBUFFER_COMPLETE;
+	}
+
+	GLenum APIENTRY CheckNamedFramebufferStatus(GLuint, GLenum)
+	{
+		NULL_GL_RECORD("glCheckNamedFramebufferStatus", 0);
+		return GL_FRAMEBUFFER_COMPLETE;
+	}
+
+	// Object names
+
+	void APIENTRY GenBuffers(GLsizei n, GLuint* names)           { NULL_GL_RECORD("glGenBuffers", 0);           GenerateNames(n, names); }
+	void APIENTRY CreateBuffers(GLsizei n, GLuint* names)        { NULL_GL_RECORD("glCreateBuffers", 0);        GenerateNames(n, names); }
+	void APIENTRY GenVertexArrays(GLsizei n, GLuint* names)      { NULL_GL_RECORD("glGenVertexArrays", 0);      GenerateNames(n, names); }
+	void APIENTRY CreateVertexArrays(GLsizei n, GLuint* names)   { NULL_GL_RECORD("glCreateVertexArrays", 0);   GenerateNames(n, names); }
+	void APIENTRY GenTextures(GLsizei n, GLuint* names)          { NULL_GL_RECORD("glGenTextures", 0);          GenerateNames(n, names); }
+	void APIENTRY CreateTextures(GLenum, GLsizei n, GLuint* names) { NULL_GL_RECORD("glCreateTextures", 0);     GenerateNames(n, names); }
+	void APIENTRY GenFramebuffers(GLsizei n, GLuint* names)      { NULL_GL_RECORD("glGenFramebuffers", 0);      GenerateNames(n, names); }
+	void APIENTRY CreateFramebuffers(GLsizei n, GLuint* names)   { NULL_GL_RECORD("glCreateFramebuffers", 0);   GenerateNames(n, names); }
+	void APIENTRY GenQueries(GLsizei n, GLuint* names)           { NULL_GL_RECORD("glGenQueries", 0);           GenerateNames(n, names); }
+	void APIENTRY CreateQueries(GLenum, GLsizei n, GLuint* names) { NULL_GL_RECORD("glCreateQueries", 0);       GenerateNames(n, names); }
+
+	// Shaders and programs
+
+	GLuint APIENTRY CreateShader(GLenum)
+	{
+		NULL_GL_RECORD("glCreateShader", 0);
+		return next_name++;
+	}
+
+	void APIENTRY ShaderSource(GLuint shader, GLsizei count, const GLchar* const* strings, const GLint* lengths)
+	{
+		std::string source;
+
+		for (GLsizei i = 0; i < count; ++i)
+			source.append(strings[i], lengths && lengths[i] >= 0 ? lengths[i] : std::strlen(strings[i]));
+
+		NULL_GL_RECORD("glShaderSource", source.size());
+		shader_uniforms[shader] = ParseUniforms(source);
+	}
+
+	void APIENTRY GetShaderiv(GLuint, GLenum name, GLint* value)
+	{
+		NULL_GL_RECORD("glGetShaderiv", 0);
+		*value = name == GL_COMPILE_STATUS ? GL_TRUE : 0;
+	}
+
+	GLuint APIENTRY CreateProgram()
+	{
+		NULL_GL_RECORD("glCreateProgram", 0);
+		return next_name++;
+	}
+
+	void APIENTRY AttachShader(GLuint program, GLuint shader)
+	{
+		NULL_GL_RECORD("glAttachShader", 0);
+		programs[program].shaders.push_back(shader);
+	}
+
+	void APIENTRY LinkProgram(GLuint program)
+	{
+		NULL_GL_RECORD("glLinkProgram", 0);
+
+		Program& linked = programs[program];
+		linked.uniforms.clear();
+
+		for (GLuint shader : linked.shaders)
+			for (const auto& uniform : shader_uniforms[shader])
+				if (std::none_of(linked.uniforms.begin(), linked.uniforms.end(), [&](const Uniform& u) { return u.name == uniform.name; }))
+					linked.uniforms.push_back(uniform);
+	}
+
+	void APIENTRY DeleteProgram(GLuint program)
+	{
+		NULL_GL_RECORD("glDeleteProgram", 0);
+		programs.erase(program);
+	}
+
+	void APIENTRY GetProgramiv(GLuint program, GLenum name, GLint* value)
+	{
+		NULL_GL_RECORD("glGetProgramiv", 0);
+
+		const std::vector<Uniform>& uniforms = programs[program].uniforms;
+
+		switch (name)
+		{
+			case GL_LINK_STATUS:
+			case GL_VALIDATE_STATUS:
+				*value = GL_TRUE;
+				break;
+
+			case GL_ACTIVE_UNIFORMS:
+				*value = static_cast<GLint>(uniforms.size());
+				break;
+
+			case GL_ACTIVE_UNIFORM_MAX_LENGTH:
+				*value = 1;
+				for (const auto& uniform : uniforms)
+					*value = std::max(*value, static_cast<GLint>(uniform.name.size() + 1));
+				break;
+
+			default:
+				*value = 0;
+				break;
+		}
+	}
+
+	void APIENTRY GetActiveUniform(GLuint program, GLuint index, GLsizei buffer_size, GLsizei* length, GLint* size, GLenum* type, GLchar* name)
+	{
+		NULL_GL_RECORD("glGetActiveUniform", 0);
+
+		const Uniform& uniform = programs[program].uniforms.at(index);
+		const GLsizei  copied  = std::min(static_cast<GLsizei>(uniform.name.size()), std::max(buffer_size - 1, 0));
+
+		std::memcpy(name, uniform.name.data(), copied);
+		name[copied] = '\0';
+
+		if (length) *length = copied;
+		*size = 1;
+		*type = uniform.type;
+	}
+
+	GLint APIENTRY GetUniformLocation(GLuint program, const GLchar* name)
+	{
+		NULL_GL_RECORD("glGetUniformLocation", 0);
+
+		const std::vector<Uniform>& uniforms = programs[program].uniforms;
+
+		for (std::size_t i = 0; i < uniforms.size(); ++i)
+			if (uniforms[i].name == name)
+				return static_cast<GLint>(i);
+
+		return -1;
+	}
+
+	void APIENTRY Uniform1f(GLint, GLfloat)                                  { NULL_GL_RECORD("glUniform1f", 4); }
+	void APIENTRY Uniform1i(GLint, GLint)                                    { NULL_GL_RECORD("glUniform1i", 4); }
+	void APIENTRY Uniform2fv(GLint, GLsizei count, const GLfloat*)           { NULL_GL_RECORD("glUniform2fv", count * 8); }
+	void APIENTRY Uniform3fv(GLint, GLsizei count, const GLfloat*)           { NULL_GL_RECORD("glUniform3fv", count * 12); }
+	void APIENTRY Uniform4fv(GLint, GLsizei count, const GLfloat*)           { NULL_GL_RECORD("glUniform4fv", count * 16); }
+	void APIENTRY UniformMatrix4fv(GLint, GLsizei count, GLboolean, const GLfloat*) { NULL_GL_RECORD("glUniformMatrix4fv", count * 64); }
+
+	// Data uploads
+
+	void APIENTRY BufferData(GLenum, GLsizeiptr size, const void*, GLenum)                   { NULL_GL_RECORD("glBufferData", size); }
+	void APIENTRY NamedBufferData(GLuint, GLsizeiptr size, const void*, GLenum)              { NULL_GL_RECORD("glNamedBufferData", size); }
+	void APIENTRY BufferStorage(GLenum, GLsizeiptr size, const void*, GLbitfield)            { NULL_GL_RECORD("glBufferStorage", size); }
+	void APIENTRY NamedBufferStorage(GLuint, GLsizeiptr size, const void*, GLbitfield)       { NULL_GL_RECORD("glNamedBufferStorage", size); }
+	void APIENTRY BufferSubData(GLenum, GLintptr, GLsizeiptr size, const void*)              { NULL_GL_RECORD("glBufferSubData", size); }
+	void APIENTRY NamedBufferSubData(GLuint, GLintptr, GLsizeiptr size, const void*)         { NULL_GL_RECORD("glNamedBufferSubData", size); }
+
+	void APIENTRY TexImage2D(GLenum, GLint, GLint, GLsizei width, GLsizei height, GLint, GLenum format, GLenum type, const void*)
+	{
+		NULL_GL_RECORD("glTexImage2D", std::uint64_t(width) * height * PixelSize(format, type));
+	}
+
+	void APIENTRY TexSubImage2D(GLenum, GLint, GLint, GLint, GLsizei width, GLsizei height, GLenum format, GLenum type, const void*)
+	{
+		NULL_GL_RECORD("glTexSubImage2D", std::uint64_t(width) * height * PixelSize(format, type));
+	}
+
+	void APIENTRY TextureSubImage2D(GLuint, GLint, GLint, GLint, GLsizei width, GLsizei height, GLenum format, GLenum type, const void*)
+	{
+		NULL_GL_RECORD("glTextureSubImage2D", std::uint64_t(width) * height * PixelSize(format, type));
+	}
+
+	void APIENTRY CompressedTexSubImage2D(GLenum, GLint, GLint, GLint, GLsizei, GLsizei, GLenum, GLsizei size, const void*)
+	{
+		NULL_GL_RECORD("glCompressedTexSubImage2D", size);
+	}
+
+	void APIENTRY CompressedTextureSubImage2D(GLuint, GLint, GLint, GLint, GLsizei, GLsizei, GLenum, GLsizei size, const void*)
+	{
+		NULL_GL_RECORD("glCompressedTextureSubImage2D", size);
+	}
+
+	void* APIENTRY MapBufferRange(GLenum, GLintptr, GLsizeiptr length, GLbitfield)
+	{
+		NULL_GL_RECORD("glMapBufferRange", length);
+
+		if (mapped_memory.size() < static_cast<std::size_t>(length))
+			mapped_memory.resize(length);
+
+		return mapped_memory.data();
+	}
+
+	GLboolean APIENTRY UnmapBuffer(GLenum)
+	{
+		NULL_GL_RECORD("glUnmapBuffer", 0);
+		return GL_TRUE;
+	}
+
+	struct TypedStub
+	{
+		const char* name;
+		void*       function;
+	};
+
+	const TypedStub typed_stubs[]
+	{
+		{ "glGetString",                   reinterpret_cast<void*>(GetString) },
+		{ "glGetStringi",                  reinterpret_cast<void*>(GetStringi) },
+		{ "glGetIntegerv",                 reinterpret_cast<void*>(GetIntegerv) },
+		{ "glGetInteger64v",               reinterpret_cast<void*>(GetInteger64v) },
+		{ "glGetQueryObjectiv",            reinterpret_cast<void*>(GetQueryObjectiv) },
+		{ "glGetQueryObjectui64v",         reinterpret_cast<void*>(GetQueryObjectui64v) },
+		{ "glCheckFramebufferStatus",      reinterpret_cast<void*>(CheckFramebufferStatus) },
+		{ "glCheckNamedFramebufferStatus", reinterpret_cast<void*>(CheckNamedFramebufferStatus) },
+		{ "glGenBuffers",                  reinterpret_cast<void*>(GenBuffers) },
+		{ "glCreateBuffers",               reinterpret_cast<void*>(CreateBuffers) },
+		{ "glGenVertexArrays",             reinterpret_cast<void*>(GenVertexArrays) },
+		{ "glCreateVertexArrays",          reinterpret_cast<void*>(CreateVertexArrays) },
+		{ "glGenTextures",                 reinterpret_cast<void*>(GenTextures) },
+		{ "glCreateTextures",              reinterpret_cast<void*>(CreateTextures) },
+		{ "glGenFramebuffers",             reinterpret_cast<void*>(GenFramebuffers) },
+		{ "glCreateFramebuffers",          reinterpret_cast<void*>(CreateFramebuffers) },
+		{ "glGenQueries",                  reinterpret_cast<void*>(GenQueries) },
+		{ "glCreateQueries",               reinterpret_cast<void*>(CreateQueries) },
+		{ "glCreateShader",                reinterpret_cast<void*>(CreateShader) },
+		{ "glShaderSource",                reinterpret_cast<void*>(ShaderSource) },
+		{ "glGetShaderiv",                 reinterpret_cast<void*>(GetShaderiv) },
+		{ "glCreateProgram",               reinterpret_cast<void*>(CreateProgram) },
+		{ "glAttachShader",                reinterpret_cast<void*>(AttachShader) },
+		{ "glLinkProgram",                 reinterpret_cast<void*>(LinkProgram) },
+		{ "glDeleteProgram",               reinterpret_cast<void*>(DeleteProgram) },
+		{ "glGetProgramiv",                reinterpret_cast<void*>(GetProgramiv) },
+		{ "glGetActiveUniform",            reinterpret_cast<void*>(GetActiveUniform) },
+		{ "glGetUniformLocation",          reinterpret_cast<void*>(GetUniformLocation) },
+		{ "glUniform1f",                   reinterpret_cast<void*>(Uniform1f) },
+		{ "glUniform1i",                   reinterpret_cast<void*>(Uniform1i) },
+		{ "glUniform2fv",                  reinterpret_cast<void*>(Uniform2fv) },
+		{ "glUniform3fv",                  reinterpret_cast<void*>(Uniform3fv) },
+		{ "glUniform4fv",                  reinterpret_cast<void*>(Uniform4fv) },
+		{ "glUniformMatrix4fv",            reinterpret_cast<void*>(UniformMatrix4fv) },
+		{ "glBufferData",                  reinterpret_cast<void*>(BufferData) },
+		{ "glNamedBufferData",             reinterpret_cast<void*>(NamedBufferData) },
+		{ "glBufferStorage",               reinterpret_cast<void*>(BufferStorage) },
+		{ "glNamedBufferStorage",          reinterpret_cast<void*>(NamedBufferStorage) },
+		{ "glBufferSubData",               reinterpret_cast<void*>(BufferSubData) },
+		{ "glNamedBufferSubData",          reinterpret_cast<void*>(NamedBufferSubData) },
+		{ "glTexImage2D",                  reinterpret_cast<void*>(TexImage2D) },
+		{ "glTexSubImage2D",               reinterpret_cast<void*>(TexSubImage2D) },
+		{ "glTextureSubImage2D",           reinterpret_cast<void*>(TextureSubImage2D) },
+		{ "glCompressedTexSubImage2D",     reinterpret_cast<void*>(CompressedTexSubImage2D) },
+		{ "glCompressedTextureSubImage2D", reinterpret_cast<void*>(CompressedTextureSubImage2D) },
+		{ "glMapBufferRange",              reinterpret_cast<void*>(MapBufferRange) },
+		{ "glUnmapBuffer",                 reinterpret_cast<void*>(UnmapBuffer) }
+	};
+}
+
+bool NullGL::load()
+{
+	return gladLoadGLLoader(getProcAddress) != 0;
+}
+
+void NullGL::setRecording(bool record)
+{
+	recording = record;
+}
+
+bool NullGL::isRecording()
+{
+	return recording;
+}
+
+std::vector<NullGL::Call> NullGL::getCalls()
+{
+	std::vector<Call> calls;
+
+	for (const auto& [name, slot] : slots)
+		if (counters[slot].count > 0)
+			calls.push_back({ slot_names[slot], counters[slot].count, counters[slot].bytes });
+
+	std::sort(calls.begin(), calls.end(), [](const Call& a, const Call& b) { return a.count > b.count; });
+
+	return calls;
+}
+
+std::uint64_t NullGL::getCallCount()
+{
+	std::uint64_t total = 0;
+
+	for (const auto& counter : counters)
+		total += counter.count;
+
+	return total;
+}
+
+std::uint64_t NullGL::getUploadedBytes()
+{
+	std::uint64_t total = 0;
+
+	for (const auto& counter : counters)
+		total += counter.bytes;
+
+	return total;
+}
+
+void NullGL::reset()
+{
+	counters.fill(Counter());
+}
+
+void* NullGL::getProcAddress(const char* name)
+{
+	auto found = slots.find(std::string_view(name));
+
+	if (found == slots.end())
+	{
+		if (slots.size() == MAX_FUNCTIONS)
+			return nullptr;
+
+		found = slots.emplace(name, slots.size()).first;
+		slot_names[found->second] = found->first.c_str();
+	}
+
+	for (const auto& stub : typed_stubs)
+		if (std::strcmp(stub.name, name) == 0)
+			return stub.function;
+
+	return reinterpret_cast<void*>(generic_stubs[found->second]);
+}
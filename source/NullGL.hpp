@@ -0,0 +1,36 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <vector>
+
+// GL without a driver, for measuring the engine's own CPU cost. load() fills glad's function pointers with stubs:
+// the ones the engine depends on behave (object names, link status, uniform reflection from the sources,
+// mapped memory), every other call does nothing. Recording counts the calls and the bytes they pass.
+// Needs a 64-bit build, the generic stub ignores the arguments of whatever function it stands in for
+class NullGL
+{
+public:
+	struct Call
+	{
+		const char*   name;
+		std::uint64_t count;
+		std::uint64_t bytes; // Buffer, texture and uniform data
+	};
+
+	// No context needed. Loading a real context through glad afterwards brings GL back
+	static bool load();
+
+	static void setRecording(bool record);
+	static bool isRecording();
+
+	// Calls since the last reset, most frequent first
+	static std::vector<Call> getCalls();
+	static std::uint64_t     getCallCount();
+	static std::uint64_t     getUploadedBytes();
+	static void              reset();
+
+private:
+	static void* getProcAddress(const char* name);
+};
@@ -0,0 +1,258 @@
+#include "Profiler.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+	struct Event
+	{
+		const char*   name;
+		std::uint64_t begin;
+		std::uint64_t end;
+	};
+
+	// Written by its thread only, count is published after the event
+	struct ThreadBuffer
+	{
+		std::unique_ptr<Event[]>   events { new Event[Profiler::BUFFER_CAPACITY] };
+		std::atomic<std::uint64_t> count  { 0 };
+		std::uint32_t              id     = 0;
+		const char*                name   = nullptr;
+	};
+
+	struct GpuQuery
+	{
+		const char*   name;
+		GLuint        begin;
+		GLuint        end;
+		std::uint64_t frame;
+	};
+
+	const auto start_time = std::chrono::steady_clock::now();
+
+	// Buffers outlive their threads, so events of finished workers still get exported
+	std::mutex                                 registry_mutex;
+	std::vector<std::unique_ptr<ThreadBuffer>> registry;
+
+	thread_local ThreadBuffer* thread_buffer = nullptr;
+
+	// GL thread only
+	std::vector<GpuQuery> gpu_queries;
+	std::vector<GLuint>   free_queries;
+	ThreadBuffer*         gpu_buffer  = nullptr;
+	std::uint64_t         frame_index = 0;
+
+	ThreadBuffer* RegisterBuffer(const char* name)
+	{
+		std::lock_guard<std::mutex> lock(registry_mutex);
+
+		auto buffer = std::make_unique<ThreadBuffer>();
+		buffer->id   = static_cast<std::uint32_t>(registry.size());
+		buffer->name = name;
+
+		registry.push_back(std::move(buffer));
+		return registry.back().get();
+	}
+
+	ThreadBuffer& GetThreadBuffer()
+	{
+		if (!thread_buffer)
+			thread_buffer = RegisterBuffer(nullptr);
+
+		return *thread_buffer;
+	}
+
+	void Write(ThreadBuffer& buffer, const char* name, std::uint64_t begin, std::uint64_t end)
+	{
+		const std::uint64_t index = buffer.count.load(std::memory_order_relaxed);
+
+		buffer.events[index % Profiler::BUFFER_CAPACITY] = { name, begin, end };
+		buffer.count.store(index + 1, std::memory_order_release);
+	}
+
+	GLuint AcquireQuery()
+	{
+		if (free_queries.empty())
+		{
+			GLuint query;
+			glGenQueries(1, &query);
+			return query;
+		}
+
+		GLuint query = free_queries.back();
+		free_queries.pop_back();
+		return query;
+	}
+
+	void WriteEscaped(std::ostream& out, const char* text)
+	{
+		for (; *text; ++text)
+		{
+			if (*text == '"' || *text == '\\')
+				out << '\\';
+			out << *text;
+		}
+	}
+}
+
+Profiler::CpuScope::CpuScope(const char* name):
+	name(isEnabled() ? name : nullptr),
+	begin(this->name ? now() : 0)
+{
+}
+
+Profiler::CpuScope::~CpuScope()
+{
+	if (name)
+		record(name, begin, now());
+}
+
+Profiler::GpuScope::GpuScope(const char* name):
+	index(SIZE_MAX)
+{
+	if (!isEnabled())
+		return;
+
+	index = gpu_queries.size();
+	gpu_queries.push_back({ name, AcquireQuery(), AcquireQuery(), frame_index });
+
+	glQueryCounter(gpu_queries.back().begin, GL_TIMESTAMP);
+}
+
+Profiler::GpuScope::~GpuScope()
+{
+	// Timestamps instead of GL_TIME_ELAPSED, elapsed time queries can't nest
+	if (index != SIZE_MAX)
+		glQueryCounter(gpu_queries[index].end, GL_TIMESTAMP);
+}
+
+void Profiler::setEnabled(bool enable)
+{
+	enabled.store(enable, std::memory_order_relaxed);
+}
+
+void Profiler::setThreadName(const char* name)
+{
+	GetThreadBuffer().name = name;
+}
+
+void Profiler::endFrame()
+{
+	frame_index++;
+
+	if (gpu_queries.empty())
+		return;
+
+	if (!gpu_buffer)
+		gpu_buffer = RegisterBuffer("GPU");
+
+	// GPU timestamps are on their own clock, the offset to ours is taken once per frame
+	GLint64 gpu_now = 0;
+	glGetInteger64v(GL_TIMESTAMP, &gpu_now);
+	const std::int64_t offset = static_cast<std::int64_t>(now()) - gpu_now;
+
+	std::size_t done = 0;
+
+	for (; done < gpu_queries.size(); ++done)
+	{
+		const GpuQuery& query = gpu_queries[done];
+
+		if (query.frame + GPU_LATENCY > frame_index)
+			break;
+
+		// Queries complete in order, the first one not ready stops the readback until the next frame
+		GLint available = GL_FALSE;
+		glGetQueryObjectiv(query.end, GL_QUERY_RESULT_AVAILABLE, &available);
+
+		if (!available)
+			break;
+
+		GLuint64 begin = 0, end = 0;
+		glGetQueryObjectui64v(query.begin, GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(query.end, GL_QUERY_RESULT, &end);
+
+		Write(*gpu_buffer, query.name, begin + offset, end + offset);
+
+		free_queries.push_back(query.begin);
+		free_queries.push_back(query.end);
+	}
+
+	gpu_queries.erase(gpu_queries.begin(), gpu_queries.begin() + done);
+}
+
+bool Profiler::writeChromeTrace(const std::string& file_path)
+{
+	std::ofstream file(file_path);
+
+	if (!file)
+	{
+		std::cout << "Failed to write trace " + file_path + '\n';
+		return false;
+	}
+
+	// Complete ("X") events in microseconds, the viewer nests them by time
+	file << "{\"traceEvents\":[\n" << std::fixed << std::setprecision(3);
+
+	bool first = true;
+	auto separator = [&]() -> std::ostream&
+	{
+		if (!first)
+			file << ",\n";
+		first = false;
+		return file;
+	};
+
+	std::lock_guard<std::mutex> lock(registry_mutex);
+
+	for (const auto& buffer : registry)
+	{
+		if (buffer->name)
+		{
+			separator() << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << buffer->id << ",\"args\":{\"name\":\"";
+			WriteEscaped(file, buffer->name);
+			file << "\"}}";
+		}
+
+		const std::uint64_t count = buffer->count.load(std::memory_order_acquire);
+		const std::uint64_t first_event = count > BUFFER_CAPACITY ? count - BUFFER_CAPACITY : 0;
+
+		for (std::uint64_t i = first_event; i < count; ++i)
+		{
+			const Event& event = buffer->events[i % BUFFER_CAPACITY];
+
+			separator() << "{\"ph\":\"X\",\"name\":\"";
+			WriteEscaped(file, event.name);
+			file << "\",\"pid\":1,\"tid\":" << buffer->id
+			     << ",\"ts\":" << event.begin / 1000.0
+			     << ",\"dur\":" << (event.end - event.begin) / 1000.0 << '}';
+		}
+	}
+
+	file << "\n]}\n";
+
+	return static_cast<bool>(file);
+}
+
+void Profiler::clear()
+{
+	std::lock_guard<std::mutex> lock(registry_mutex);
+
+	for (const auto& buffer : registry)
+		buffer->count.store(0, std::memory_order_relaxed);
+}
+
+std::uint64_t Profiler::now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+void Profiler::record(const char* name, std::uint64_t begin, std::uint64_t end)
+{
+	Write(GetThreadBuffer(), name, begin, end);
+}
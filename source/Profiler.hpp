@@ -0,0 +1,82 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Set to 0 to compile every profiler scope out
+#ifndef ENGINE_PROFILER
+#define ENGINE_PROFILER 1
+#endif
+
+// Frame instrumentation exported as Chrome trace events (chrome://tracing, Perfetto, Speedscope).
+// CPU scopes are timed into a ring buffer per thread, GPU scopes by timestamp queries that are
+// read back a few frames later, so the GL thread never waits for them. A disabled profiler costs
+// one relaxed load per scope
+class Profiler
+{
+public:
+	// Events kept per thread, older ones are overwritten
+	static constexpr std::size_t BUFFER_CAPACITY = 1 << 16;
+	// Frames GPU queries have to complete before they're read back
+	static constexpr unsigned    GPU_LATENCY = 3;
+
+	// Times the enclosing block on the calling thread. Scopes nest
+	class CpuScope
+	{
+	public:
+		explicit CpuScope(const char* name);
+		~CpuScope();
+
+	private:
+		const char*   name;
+		std::uint64_t begin;
+	};
+
+	// Times the GL commands issued in the enclosing block. GL thread only, must not span endFrame()
+	class GpuScope
+	{
+	public:
+		explicit GpuScope(const char* name);
+		~GpuScope();
+
+	private:
+		std::size_t index;
+	};
+
+	static void setEnabled(bool enable);
+	static bool isEnabled()
+	{
+		return enabled.load(std::memory_order_relaxed);
+	}
+
+	// Shown as the track name in the trace. The name must outlive the profiler
+	static void setThreadName(const char* name);
+
+	// Collects the finished GPU queries. Once per frame from the GL thread
+	static void endFrame();
+
+	// Writes every event still in the buffers. Call while other threads are not profiling
+	static bool writeChromeTrace(const std::string& file_path);
+	static void clear();
+
+	// Nanoseconds since the profiler started
+	static std::uint64_t now();
+
+private:
+	static void record(const char* name, std::uint64_t begin, std::uint64_t end);
+
+	static inline std::atomic<bool> enabled { false };
+};
+
+#if ENGINE_PROFILER
+#define PROFILE_JOIN_IMPL(a, b) a##b
+#define PROFILE_JOIN(a, b) PROFILE_JOIN_IMPL(a, b)
+#define PROFILE_SCOPE(name) Profiler::CpuScope PROFILE_JOIN(profile_scope_, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(name) Profiler::GpuScope PROFILE_JOIN(profile_gpu_scope_, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_GPU_SCOPE(name)
+#endif
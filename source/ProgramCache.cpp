@@ -0,0 +1,160 @@
+#include "ProgramCache.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+#include <vector>
+
+namespace
+{
+	const char MAGIC[8] { 'O', 'G', 'E', 'P', 'R', 'G', '0', '1' };
+
+	struct EntryHeader
+	{
+		char          magic[8];
+		std::uint64_t source_hash;
+		std::uint32_t driver_length;
+		std::uint32_t binary_format;
+		std::uint32_t binary_length;
+		std::uint32_t reserved;
+	};
+}
+
+ProgramCache::ProgramCache(const std::string& directory):
+	directory(directory)
+{
+	if (!this->directory.empty() && this->directory.back() != '/' && this->directory.back() != '\\')
+		this->directory += '/';
+}
+
+std::uint64_t ProgramCache::hash(const void* data, std::size_t size, std::uint64_t seed)
+{
+	const auto* bytes = static_cast<const unsigned char*>(data);
+
+	for (std::size_t i = 0; i < size; ++i)
+		seed = (seed ^ bytes[i]) * 1099511628211ull;
+
+	return seed;
+}
+
+bool ProgramCache::isSupported()
+{
+	if (!GLAD_GL_VERSION_4_1)
+		return false;
+
+	GLint format_count = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+
+	return format_count > 0;
+}
+
+bool ProgramCache::load(GLuint program, std::uint64_t source_hash)
+{
+	if (!isSupported())
+		return false;
+
+	std::ifstream file(getEntryPath(source_hash), std::ios::binary);
+
+	if (!file.is_open())
+		return false;
+
+	EntryHeader header;
+	const std::string& current_driver = getDriver();
+
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+		std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+		header.source_hash != source_hash ||
+		header.driver_length != current_driver.size())
+		return false;
+
+	std::string stored_driver(header.driver_length, '\0');
+	std::vector<char> binary(header.binary_length);
+
+	if (!file.read(stored_driver.data(), stored_driver.size()) || stored_driver != current_driver ||
+		!file.read(binary.data(), binary.size()))
+		return false;
+
+	glProgramBinary(program, header.binary_format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+	// Drivers may still refuse a binary they wrote, e.g. after an update with the same version string
+	GLint success = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+	return success != 0;
+}
+
+void ProgramCache::save(GLuint program, std::uint64_t source_hash)
+{
+	if (!isSupported())
+		return;
+
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+	if (length <= 0)
+		return;
+
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(program, length, &length, &format, binary.data());
+
+	const std::string& current_driver = getDriver();
+
+	EntryHeader header {};
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.source_hash   = source_hash;
+	header.driver_length = static_cast<std::uint32_t>(current_driver.size());
+	header.binary_format = format;
+	header.binary_length = static_cast<std::uint32_t>(length);
+
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+
+	const std::string entry_path     = getEntryPath(source_hash);
+	const std::string temporary_path = entry_path + ".tmp";
+	{
+		std::ofstream file(temporary_path, std::ios::binary);
+
+		if (!file.is_open() ||
+			!file.write(reinterpret_cast<const char*>(&header), sizeof(header)) ||
+			!file.write(current_driver.data(), current_driver.size()) ||
+			!file.write(binary.data(), length))
+		{
+			std::cout << "Failed to write program cache " + temporary_path + '\n';
+			return;
+		}
+	}
+
+	std::filesystem::rename(temporary_path, entry_path, error);
+
+	if (error)
+		std::filesystem::remove(temporary_path, error);
+}
+
+const std::string& ProgramCache::getDriver()
+{
+	if (driver.empty())
+	{
+		for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+		{
+			if (const GLubyte* value = glGetString(name))
+				driver += reinterpret_cast<const char*>(value);
+			driver += '\n';
+		}
+	}
+	return driver;
+}
+
+std::string ProgramCache::getEntryPath(std::uint64_t source_hash)
+{
+	const std::string& current_driver = getDriver();
+	const std::uint64_t key = hash(current_driver.data(), current_driver.size(), source_hash);
+
+	char name[17];
+	std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+
+	return directory + name + ".bin";
+}
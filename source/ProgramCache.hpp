@@ -0,0 +1,34 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <string>
+
+// Disk cache of linked program binaries (glGetProgramBinary), so warm starts skip shader compilation.
+// Entries are keyed by a hash of the sources and tied to the driver that produced them: another GPU,
+// driver or driver version makes them miss and the program is compiled from source again.
+// Needs a GL context; without GL 4.1 or binary formats it always misses.
+class ProgramCache
+{
+public:
+	explicit ProgramCache(const std::string& directory = "cache/shaders/");
+
+	// FNV-1a, chain calls through seed to hash several sources
+	static std::uint64_t hash(const void* data, std::size_t size, std::uint64_t seed = 14695981039346656037ull);
+
+	// Links the program from a stored binary. False on a miss or when the driver rejects the binary
+	bool load(GLuint program, std::uint64_t source_hash);
+	// Stores a program linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+	void save(GLuint program, std::uint64_t source_hash);
+
+	// Binary formats are available, otherwise load and save do nothing
+	static bool isSupported();
+
+private:
+	const std::string& getDriver();
+	std::string getEntryPath(std::uint64_t source_hash);
+
+	std::string directory;
+	std::string driver; // Vendor, renderer and version strings, read on first use
+};
@@ -0,0 +1,103 @@
+#include "RenderQueue.hpp"
+#include "Profiler.hpp"
+
+RenderQueue::RenderQueue():
+	is_sorted(true)
+{
+}
+
+std::uint64_t RenderQueue::makeKey(std::uint8_t layer, GLuint shader, GLuint texture, std::uint32_t depth)
+{
+	return (std::uint64_t(layer)             << 56) |
+		   (std::uint64_t(shader  & 0xFFFF)  << 40) |
+		   (std::uint64_t(texture & 0xFFFF)  << 24) |
+		    std::uint64_t(depth   & 0xFFFFFF);
+}
+
+void RenderQueue::submit(const RenderCommand& command)
+{
+	entries.push_back({ command.key, static_cast<std::uint32_t>(commands.size()) });
+	commands.push_back(command);
+	is_sorted = false;
+}
+
+void RenderQueue::sort()
+{
+	if (is_sorted || entries.empty()) return;
+
+	swap_buffer.resize(entries.size());
+
+	// LSD radix sort, 8 bits per pass. Stable, so equal keys keep submission order
+	for (unsigned shift = 0; shift < 64; shift += 8)
+	{
+		std::size_t counts[256] {};
+
+		for (const auto& entry : entries)
+			counts[(entry.key >> shift) & 0xFF]++;
+
+		// All keys share this digit, nothing to reorder
+		if (counts[(entries[0].key >> shift) & 0xFF] == entries.size())
+			continue;
+
+		std::size_t offset = 0;
+		for (auto& count : counts)
+		{
+			std::size_t current = count;
+			count = offset;
+			offset += current;
+		}
+
+		for (const auto& entry : entries)
+			swap_buffer[counts[(entry.key >> shift) & 0xFF]++] = entry;
+
+		entries.swap(swap_buffer);
+	}
+	is_sorted = true;
+}
+
+void RenderQueue::execute()
+{
+	if (entries.empty()) return;
+
+	PROFILE_SCOPE("RenderQueue::execute");
+	PROFILE_GPU_SCOPE("RenderQueue");
+
+	sort();
+
+	ShaderProgram* current_shader  = nullptr;
+	Texture*       current_texture = nullptr;
+
+	for (const auto& entry : entries)
+	{
+		const RenderCommand& command = commands[entry.index];
+
+		if (command.shader != current_shader)
+		{
+			current_shader = command.shader;
+			current_shader->use();
+		}
+
+		if (command.texture != current_texture)
+		{
+			current_texture = command.texture;
+			current_texture->bind(true);
+		}
+
+		command.draw(command.object, command.shader);
+	}
+
+	if (current_texture)
+		current_texture->bind(false);
+}
+
+void RenderQueue::clear()
+{
+	commands.clear();
+	entries.clear();
+	is_sorted = true;
+}
+
+std::size_t RenderQueue::size() const
+{
+	return commands.size();
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "Texture.hpp"
+#include "ShaderProgram.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Lightweight draw request. The queue binds shader and texture, the callback issues the draw itself
+struct RenderCommand
+{
+	using DrawFunc = void(*)(void* object, ShaderProgram* shader);
+
+	std::uint64_t  key     = 0;
+	ShaderProgram* shader  = nullptr;
+	Texture*       texture = nullptr;
+	void*          object  = nullptr;
+	DrawFunc       draw    = nullptr;
+};
+
+// Collects commands from independent systems, sorts them by key once per frame
+// and executes them with as few shader/texture switches as possible.
+// Key layout (most significant first): | layer : 8 | shader : 16 | texture : 16 | depth : 24 |
+class RenderQueue
+{
+public:
+	RenderQueue();
+
+	static std::uint64_t makeKey(std::uint8_t layer, GLuint shader, GLuint texture, std::uint32_t depth);
+
+	void submit(const RenderCommand& command);
+	void sort();
+	void execute();
+	void clear();
+
+	std::size_t size() const;
+
+private:
+	struct SortEntry
+	{
+		std::uint64_t key;
+		std::uint32_t index;
+	};
+
+	std::vector<RenderCommand> commands;
+	std::vector<SortEntry>     entries;
+	std::vector<SortEntry>     swap_buffer;
+	bool                       is_sorted;
+};
@@ -0,0 +1,133 @@
+#include "RenderStats.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+RenderStats::RenderStats(std::size_t window):
+	frames(std::max<std::size_t>(window, 1)),
+	next(0),
+	count(0),
+	frame_index(0),
+	last_counters(GLState::getCounters()),
+	csv_interval(0),
+	csv_pending(0)
+{
+}
+
+RenderStats::~RenderStats()
+{
+	// Frames short of a full interval go out too
+	if (csv.is_open() && csv_pending > 0)
+		writeCsv();
+}
+
+void RenderStats::endFrame(float frame_time)
+{
+	const GLState::Counters& counters = GLState::getCounters();
+
+	FrameStats& stats = frames[next];
+	stats.frame          = frame_index++;
+	stats.frame_time     = frame_time;
+	stats.draw_calls     = counters.draw_calls     - last_counters.draw_calls;
+	stats.triangles      = counters.triangles      - last_counters.triangles;
+	stats.state_changes  = counters.issued         - last_counters.issued;
+	stats.skipped        = counters.skipped        - last_counters.skipped;
+	stats.program_binds  = counters.program_binds  - last_counters.program_binds;
+	stats.texture_binds  = counters.texture_binds  - last_counters.texture_binds;
+	stats.buffer_uploads = counters.buffer_uploads - last_counters.buffer_uploads;
+	stats.uploaded_bytes = counters.uploaded_bytes - last_counters.uploaded_bytes;
+
+	last_counters = counters;
+	next  = (next + 1) % frames.size();
+	count = std::min(count + 1, frames.size());
+
+	if (csv.is_open() && ++csv_pending >= csv_interval)
+		writeCsv();
+}
+
+bool RenderStats::setCsvOutput(const std::string& file_path, std::size_t interval)
+{
+	if (csv.is_open())
+		csv.close();
+
+	csv_pending = 0;
+
+	if (file_path.empty())
+		return true;
+
+	csv.open(file_path);
+
+	if (!csv)
+	{
+		std::cout << "Failed to open render stats file " + file_path + '\n';
+		return false;
+	}
+
+	// Rows come from the window, a longer interval would lose frames
+	csv_interval = std::clamp<std::size_t>(interval, 1, frames.size());
+
+	csv << "frame,frame_time_ms,draw_calls,triangles,state_changes,skipped,program_binds,texture_binds,buffer_uploads,uploaded_bytes\n";
+	return true;
+}
+
+const FrameStats& RenderStats::getLast() const
+{
+	return frames[(next + frames.size() - 1) % frames.size()];
+}
+
+RenderStats::Summary RenderStats::getFrameTimeSummary() const
+{
+	Summary summary;
+
+	if (count == 0)
+		return summary;
+
+	std::vector<float> times;
+	times.reserve(count);
+
+	for (std::size_t i = 0; i < count; ++i)
+		times.push_back(frames[i].frame_time);
+
+	std::sort(times.begin(), times.end());
+
+	// Nearest rank percentiles
+	auto percentile = [&](float p)
+	{
+		const std::size_t rank = static_cast<std::size_t>(p * (times.size() - 1) + 0.5f);
+		return times[rank];
+	};
+
+	float total = 0;
+	for (float time : times)
+		total += time;
+
+	summary.min     = times.front();
+	summary.average = total / times.size();
+	summary.max     = times.back();
+	summary.p50     = percentile(0.50f);
+	summary.p95     = percentile(0.95f);
+	summary.p99     = percentile(0.99f);
+
+	return summary;
+}
+
+std::size_t RenderStats::getFrameCount() const
+{
+	return static_cast<std::size_t>(frame_index);
+}
+
+void RenderStats::writeCsv()
+{
+	// The last csv_pending frames in order, oldest first
+	for (std::size_t i = csv_pending; i > 0; --i)
+	{
+		const FrameStats& stats = frames[(next + frames.size() - i) % frames.size()];
+
+		csv << stats.frame << ',' << stats.frame_time * 1000.0f << ',' << stats.draw_calls << ',' << stats.triangles << ','
+		    << stats.state_changes << ',' << stats.skipped << ',' << stats.program_binds << ',' << stats.texture_binds << ','
+		    << stats.buffer_uploads << ',' << stats.uploaded_bytes << '\n';
+	}
+
+	csv.flush();
+	csv_pending = 0;
+}
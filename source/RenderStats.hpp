@@ -0,0 +1,65 @@
+#pragma once
+
+#include "GLState.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// What one frame cost, taken from the GLState counters
+struct FrameStats
+{
+	std::uint64_t frame          = 0;
+	float         frame_time     = 0; // Seconds
+	std::size_t   draw_calls     = 0;
+	std::size_t   triangles      = 0;
+	std::size_t   state_changes  = 0;
+	std::size_t   skipped        = 0; // Redundant state changes GLState filtered out
+	std::size_t   program_binds  = 0;
+	std::size_t   texture_binds  = 0;
+	std::size_t   buffer_uploads = 0;
+	std::size_t   uploaded_bytes = 0;
+};
+
+// Per frame render statistics over a rolling window of recent frames, optionally appended to a CSV file
+class RenderStats
+{
+public:
+	struct Summary
+	{
+		float min     = 0;
+		float average = 0;
+		float max     = 0;
+		float p50     = 0;
+		float p95     = 0;
+		float p99     = 0;
+	};
+
+	explicit RenderStats(std::size_t window = 600);
+	~RenderStats();
+
+	// Closes the frame: everything counted since the last call belongs to it. Once per frame
+	void endFrame(float frame_time);
+
+	// Rows of the frames since the last dump are appended every interval frames. An empty path turns it off
+	bool setCsvOutput(const std::string& file_path, std::size_t interval = 60);
+
+	const FrameStats& getLast() const;
+	// Frame times in seconds over the window
+	Summary           getFrameTimeSummary() const;
+	std::size_t       getFrameCount() const;
+
+private:
+	void writeCsv();
+
+	std::vector<FrameStats> frames; // Ring over the window
+	std::size_t             next;
+	std::size_t             count;
+	std::uint64_t           frame_index;
+	GLState::Counters       last_counters;
+
+	std::ofstream csv;
+	std::size_t   csv_interval;
+	std::size_t   csv_pending;
+};
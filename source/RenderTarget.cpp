@@ -0,0 +1,143 @@
+#include "RenderTarget.hpp"
+#include "GLState.hpp"
+
+#include "stb_image_write.h"
+
+#include <algorithm>
+#include <iostream>
+
+RenderTarget::RenderTarget():
+	framebuffer(0),
+	color_texture(0),
+	size(0)
+{
+}
+
+RenderTarget::~RenderTarget()
+{
+	destroy();
+}
+
+bool RenderTarget::create(const glm::ivec2& new_size)
+{
+	destroy();
+	size = new_size;
+
+	GLenum status;
+
+	if (GLState::hasDirectStateAccess())
+	{
+		glCreateTextures(GL_TEXTURE_2D, 1, &color_texture);
+		glTextureStorage2D(color_texture, 1, GL_RGBA8, size.x, size.y);
+
+		glCreateFramebuffers(1, &framebuffer);
+		glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT0, color_texture, 0);
+
+		status = glCheckNamedFramebufferStatus(framebuffer, GL_FRAMEBUFFER);
+	}
+	else
+	{
+		glGenTextures(1, &color_texture);
+		GLState::bindTexture(0, color_texture);
+		glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, size.x, size.y);
+
+		glGenFramebuffers(1, &framebuffer);
+		GLState::bindFramebuffer(framebuffer);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color_texture, 0);
+
+		status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		GLState::bindFramebuffer(0);
+	}
+
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Framebuffer is not complete: " << status << '\n';
+		destroy();
+		return false;
+	}
+
+	return true;
+}
+
+void RenderTarget::bind()
+{
+	GLState::bindFramebuffer(framebuffer);
+	glViewport(0, 0, size.x, size.y);
+}
+
+void RenderTarget::unbind()
+{
+	GLState::bindFramebuffer(0);
+}
+
+void RenderTarget::readPixels(std::vector<unsigned char>& pixels) const
+{
+	const std::size_t row_size = static_cast<std::size_t>(size.x) * 4;
+	std::vector<unsigned char> flipped(row_size * size.y);
+
+	glFinish();
+
+	GLState::bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+	if (GLState::hasDirectStateAccess())
+	{
+		glNamedFramebufferReadBuffer(framebuffer, GL_COLOR_ATTACHMENT0);
+		GLState::bindFramebuffer(framebuffer);
+	}
+	else
+	{
+		GLState::bindFramebuffer(framebuffer);
+		glReadBuffer(GL_COLOR_ATTACHMENT0);
+	}
+
+	glReadPixels(0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, flipped.data());
+
+	// GL rows go bottom to top, images top to bottom
+	pixels.resize(flipped.size());
+
+	for (int row = 0; row < size.y; ++row)
+		std::copy_n(flipped.data() + (size.y - 1 - row) * row_size, row_size, pixels.data() + row * row_size);
+}
+
+bool RenderTarget::saveToPng(const std::string& file_path) const
+{
+	std::vector<unsigned char> pixels;
+	readPixels(pixels);
+
+	if (!stbi_write_png(file_path.c_str(), size.x, size.y, 4, pixels.data(), size.x * 4))
+	{
+		std::cout << "Failed to write image " + file_path + '\n';
+		return false;
+	}
+
+	return true;
+}
+
+const glm::ivec2& RenderTarget::getSize() const
+{
+	return size;
+}
+
+GLuint RenderTarget::getColorTexture() const
+{
+	return color_texture;
+}
+
+void RenderTarget::destroy()
+{
+	if (framebuffer)
+	{
+		glDeleteFramebuffers(1, &framebuffer);
+		GLState::onFramebufferDeleted(framebuffer);
+	}
+
+	if (color_texture)
+	{
+		glDeleteTextures(1, &color_texture);
+		GLState::onTextureDeleted(color_texture);
+	}
+
+	framebuffer   = 0;
+	color_texture = 0;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+// Offscreen framebuffer with an RGBA8 color texture. Headless contexts have no default framebuffer
+// and draw into one of these, which can then be read back or saved as PNG for image comparisons
+class RenderTarget
+{
+public:
+	RenderTarget();
+	RenderTarget(const RenderTarget&) = delete;
+	RenderTarget& operator = (const RenderTarget&) = delete;
+	~RenderTarget();
+
+	bool create(const glm::ivec2& size);
+
+	// Following draws go here, the viewport is set to the whole target
+	void bind();
+	// Back to the default framebuffer
+	void unbind();
+
+	// Rows top to bottom, 4 bytes per pixel
+	void readPixels(std::vector<unsigned char>& pixels) const;
+	bool saveToPng(const std::string& file_path) const;
+
+	const glm::ivec2& getSize() const;
+	GLuint            getColorTexture() const;
+
+private:
+	void destroy();
+
+	GLuint     framebuffer;
+	GLuint     color_texture;
+	glm::ivec2 size;
+};
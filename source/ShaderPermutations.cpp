@@ -0,0 +1,89 @@
+#include "ShaderPermutations.hpp"
+#include "ShaderWatcher.hpp"
+
+#include <iostream>
+
+ShaderPermutations::ShaderPermutations(const std::string& vertex_path, const std::string& fragment_path, const std::vector<std::string>& feature_names):
+	vertex_path(vertex_path),
+	fragment_path(fragment_path),
+	features(feature_names),
+	watcher(nullptr)
+{
+	if (features.size() > MAX_FEATURES)
+	{
+		std::cout << "Shader " << fragment_path << " has too many features, the last ones are ignored\n";
+		features.resize(MAX_FEATURES);
+	}
+
+	programs.resize(std::size_t(1) << features.size());
+}
+
+ShaderPermutations::~ShaderPermutations()
+{
+	setWatcher(nullptr);
+}
+
+ShaderProgram* ShaderPermutations::get(std::uint32_t variant)
+{
+	variant &= static_cast<std::uint32_t>(programs.size() - 1);
+
+	if (std::unique_ptr<ShaderProgram>& program = programs[variant])
+		return program->isLinked() ? program.get() : getFallback(variant);
+
+	auto program = std::make_unique<ShaderProgram>();
+
+	for (std::size_t i = 0; i < features.size(); ++i)
+		if (variant & (1u << i))
+			program->addDefine(features[i]);
+
+	program->compile(vertex_path.c_str(), GL_VERTEX_SHADER);
+	program->compile(fragment_path.c_str(), GL_FRAGMENT_SHADER);
+
+	// A failed variant is kept for the watcher to reload once its sources are fixed,
+	// without a watcher they can't change and linking again would fail the same way
+	if (!program->link())
+		std::cout << "Shader variant " << variant << " of " << fragment_path << " failed to link\n";
+
+	if (watcher)
+		watcher->watch(program.get());
+
+	programs[variant] = std::move(program);
+	return programs[variant]->isLinked() ? programs[variant].get() : getFallback(variant);
+}
+
+ShaderProgram* ShaderPermutations::getFallback(std::uint32_t variant)
+{
+	// Variant 0 draws without the features but draws, nullptr when it doesn't link either
+	return variant != 0 ? get(0) : nullptr;
+}
+
+void ShaderPermutations::preload(const std::vector<std::uint32_t>& variants)
+{
+	for (std::uint32_t variant : variants)
+		get(variant);
+}
+
+void ShaderPermutations::setWatcher(ShaderWatcher* new_watcher)
+{
+	for (const auto& program : programs)
+		if (program)
+		{
+			if (watcher)
+				watcher->unwatch(program.get());
+
+			if (new_watcher)
+				new_watcher->watch(program.get());
+		}
+
+	watcher = new_watcher;
+}
+
+std::size_t ShaderPermutations::getVariantCount() const
+{
+	std::size_t count = 0;
+
+	for (const auto& program : programs)
+		count += program != nullptr;
+
+	return count;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "ShaderProgram.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class ShaderWatcher;
+
+// Variants of one vertex + fragment shader pair. Bit i of a variant key adds "#define <feature i>"
+// to both stages, so a draw pays only for the features it uses. Programs are linked on first use
+// and kept in a table indexed by the key.
+class ShaderPermutations
+{
+public:
+	static constexpr std::size_t MAX_FEATURES = 8;
+
+	ShaderPermutations(const std::string& vertex_path, const std::string& fragment_path, const std::vector<std::string>& feature_names);
+	ShaderPermutations(const ShaderPermutations&) = delete;
+	ShaderPermutations& operator = (const ShaderPermutations&) = delete;
+	~ShaderPermutations();
+
+	// Links the variant when it's requested for the first time. Must be called from the GL thread.
+	// Until a variant links, variant 0 stands in for it, nullptr when variant 0 fails as well
+	ShaderProgram* get(std::uint32_t variant);
+	// Links variants ahead of time, so their first draw doesn't stall on the compiler
+	void preload(const std::vector<std::uint32_t>& variants);
+
+	// Variants, existing and future, are reloaded when their sources change
+	void setWatcher(ShaderWatcher* watcher);
+
+	std::size_t getVariantCount() const;
+
+private:
+	ShaderProgram* getFallback(std::uint32_t variant);
+
+	std::string                                 vertex_path;
+	std::string                                 fragment_path;
+	std::vector<std::string>                    features;
+	std::vector<std::unique_ptr<ShaderProgram>> programs; // Indexed by the variant key
+	ShaderWatcher*                              watcher;
+};
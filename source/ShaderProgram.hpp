@@ -2,91 +2,307 @@
 
 #include <glad/glad.h>
 
+#include "GLState.hpp"
+#include "ProgramCache.hpp"
+#include "Profiler.hpp"
+
 #include <glm/gtc/type_ptr.hpp>
 
 #include <string>
-#include <map>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
 #include <fstream>
-#include <sstream>
 #include <iostream>
 
+// Uniform name hashed with FNV-1a. Constexpr, so "constexpr UniformName MODEL("model")" costs nothing at run time.
+// Lookups compare the name too when the hash matches, so a colliding name never sets another uniform
+struct UniformName
+{
+	constexpr UniformName(const char* name) : hash(2166136261u), name(name)
+	{
+		for (const char* c = name; *c; ++c)
+			hash = (hash ^ static_cast<unsigned char>(*c)) * 16777619u;
+	}
+
+	std::uint32_t hash;
+	const char*   name; // Only valid as long as the string it was made from
+};
+
+// Resolved uniform of a known type. Setting it is an array index plus the GL call,
+// the handle stays valid when the program is linked again
+template <typename T>
+struct Uniform
+{
+	std::uint32_t index = ~0u;
+
+	bool isValid() const { return index != ~0u; }
+};
+
 class ShaderProgram
 {
 public:
-	ShaderProgram() : id(glCreateProgram())
+	ShaderProgram() : id(glCreateProgram()), is_linked(false)
 	{
 	}
 
 	~ShaderProgram()
 	{
-		if (id) glDeleteProgram(id);
+		if (id)
+		{
+			glDeleteProgram(id);
+			GLState::onProgramDeleted(id);
+		}
 	}
 
-	void compile(const char* shader_path, GLenum shader_type)
+	// Reads the source of one stage. Nothing is compiled until link()
+	bool compile(const char* shader_path, GLenum shader_type)
 	{
-		std::string shader_code;
-		std::ifstream shader_file;
-		const char* c_shader_code;
+		Stage stage { shader_type, shader_path, {} };
 
-		shader_file.open(shader_path);
+		if (!readSource(stage))
+			return false;
 
-		if (shader_file.is_open())
-		{
-			std::stringstream shader_stream;
-			shader_stream << shader_file.rdbuf();
+		stages.push_back(std::move(stage));
+		return true;
+	}
+
+	// Adds "#define name" to every stage right after its #version line. Takes effect on the next link
+	void addDefine(const std::string& name)
+	{
+		defines += "#define " + name + '\n';
+	}
 
-			shader_file.close();
+	// Links all the stages read by compile(). A program cache (see setProgramCache) turns warm starts
+	// into a single glProgramBinary, sources are compiled only on a miss
+	bool link()
+	{
+		PROFILE_SCOPE("ShaderProgram::link");
 
-			shader_code = shader_stream.str();
-			c_shader_code = shader_code.c_str();
-		}
-		else
+		if (!linkProgram(id, stages, defines))
+			return false;
+
+		reflectUniforms();
+		is_linked = true;
+
+		return true;
+	}
+
+	// Reads every stage from its file again and links a new program. Only a successful link replaces
+	// the current one, on errors the old program stays in use. Uniform handles stay valid either way
+	bool reload()
+	{
+		std::vector<Stage> new_stages = stages;
+
+		for (auto& stage : new_stages)
+			if (!readSource(stage))
+				return false;
+
+		GLuint new_id = glCreateProgram();
+
+		if (!linkProgram(new_id, new_stages, defines))
 		{
-			std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ\n";
-			return;
+			glDeleteProgram(new_id);
+			return false;
 		}
 
-		GLuint shader_id = glCreateShader(shader_type);
+		glDeleteProgram(id);
+		GLState::onProgramDeleted(id);
+
+		id        = new_id;
+		stages    = std::move(new_stages);
+		is_linked = true;
+		reflectUniforms();
+
+		return true;
+	}
+
+	std::vector<std::string> getSourcePaths() const
+	{
+		std::vector<std::string> paths;
 
-		glShaderSource(shader_id, 1, &c_shader_code, NULL);
-		glCompileShader(shader_id);
-		checkCompileErrors(shader_id, "SHADER");
+		for (const auto& stage : stages)
+			paths.push_back(stage.path);
 
-		glAttachShader(id, shader_id);
-		glLinkProgram(id);
-		checkCompileErrors(id, "PROGRAM");
+		return paths;
+	}
 
-		glDeleteShader(shader_id);
+	// When set, linked programs are stored in and loaded from this cache
+	static void setProgramCache(ProgramCache* cache)
+	{
+		program_cache = cache;
 	}
 
 	void use()
 	{
-		glUseProgram(id);
+		GLState::useProgram(id);
 	}
 
-	void addUniform(const char* name)
+	GLuint getNativeHandle() const
 	{
-		GLuint location = glGetUniformLocation(id, name);
-		uniform_locations.try_emplace(name, location);
+		return id;
 	}
 
-	void setUniform(const char* name, float value)
+	// False until link() or reload() succeeds, such a program must not be drawn with
+	bool isLinked() const
 	{
-		glUniform1f(uniform_locations[name], value);
+		return is_linked;
+	}
+
+	// Handles outlive relinking: every link resolves them again by name
+	template <typename T>
+	Uniform<T> getUniform(UniformName name)
+	{
+		Uniform<T> uniform;
+
+		std::uint32_t index = 0;
+
+		while (index < handle_hashes.size() && (handle_hashes[index] != name.hash || handle_names[index] != name.name))
+			index++;
+
+		uniform.index = index;
+
+		if (index == handle_hashes.size())
+		{
+			handle_hashes.push_back(name.hash);
+			handle_names.push_back(name.name);
+			handle_locations.push_back(findLocation(name));
+		}
+
+		if (const ActiveUniform* active = findActive(name.hash, name.name); active && active->type != GetUniformType<T>() && GetUniformType<T>() != GL_INT)
+			std::cout << "Uniform " << active->name << " is used with a different type\n";
+
+		return uniform;
 	}
 
-	void setUniform(const char* name, const glm::vec3& vec)
+	template <typename T>
+	void setUniform(Uniform<T> uniform, const T& value)
 	{
-		glUniform3f(uniform_locations[name], vec.x, vec.y, vec.z);
+		if (uniform.index < handle_locations.size())
+			upload(handle_locations[uniform.index], value);
 	}
 
-	void setUniform(const char* name, const float* matrix)
+	// Without a handle: a binary search over the active uniforms, unknown names are ignored
+	void setUniform(UniformName name, float value)            { upload(findLocation(name), value); }
+	void setUniform(UniformName name, int value)              { upload(findLocation(name), value); }
+	void setUniform(UniformName name, const glm::vec2& value) { upload(findLocation(name), value); }
+	void setUniform(UniformName name, const glm::vec3& value) { upload(findLocation(name), value); }
+	void setUniform(UniformName name, const glm::vec4& value) { upload(findLocation(name), value); }
+	void setUniform(UniformName name, const glm::mat4& value) { upload(findLocation(name), value); }
+
+	// Location of an active uniform, -1 when the program has none with that name
+	GLint findLocation(UniformName name) const
 	{
-		glUniformMatrix4fv(uniform_locations[name], 1, GL_FALSE, matrix);
+		const ActiveUniform* active = findActive(name.hash, name.name);
+		return active ? active->location : -1;
 	}
 
 private:
-	void checkCompileErrors(GLuint shader, const std::string& type)
+	struct Stage
+	{
+		GLenum      type;
+		std::string path;
+		std::string source;
+	};
+
+	static bool readSource(Stage& stage)
+	{
+		std::ifstream shader_file(stage.path, std::ios::binary | std::ios::ate);
+
+		if (!shader_file.is_open())
+		{
+			std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ " << stage.path << "\n";
+			return false;
+		}
+
+		stage.source.assign(static_cast<std::size_t>(shader_file.tellg()), '\0');
+		shader_file.seekg(0);
+		shader_file.read(stage.source.data(), stage.source.size());
+
+		return true;
+	}
+
+	// GLSL wants #version first, everything else may follow it
+	static std::string injectDefines(const std::string& source, const std::string& defines)
+	{
+		if (defines.empty())
+			return source;
+
+		std::size_t position = 0;
+
+		if (source.compare(0, 8, "#version") == 0)
+		{
+			position = source.find('\n');
+			position = position == std::string::npos ? source.size() : position + 1;
+		}
+
+		std::string result = source.substr(0, position);
+
+		if (!result.empty() && result.back() != '\n')
+			result += '\n';
+
+		return result + defines + source.substr(position);
+	}
+
+	static bool linkProgram(GLuint program, const std::vector<Stage>& stages, const std::string& defines)
+	{
+		std::vector<std::string> sources;
+		std::uint64_t source_hash = ProgramCache::hash(nullptr, 0);
+
+		for (const auto& stage : stages)
+		{
+			sources.push_back(injectDefines(stage.source, defines));
+
+			source_hash = ProgramCache::hash(&stage.type, sizeof(stage.type), source_hash);
+			source_hash = ProgramCache::hash(sources.back().data(), sources.back().size(), source_hash);
+		}
+
+		if (program_cache && program_cache->load(program, source_hash))
+			return true;
+
+		std::vector<GLuint> shaders;
+		bool is_compiled = true;
+
+		for (std::size_t i = 0; i < stages.size(); ++i)
+		{
+			const char* c_shader_code = sources[i].c_str();
+
+			GLuint shader_id = glCreateShader(stages[i].type);
+			glShaderSource(shader_id, 1, &c_shader_code, NULL);
+			glCompileShader(shader_id);
+
+			is_compiled = checkCompileErrors(shader_id, "SHADER") && is_compiled;
+
+			glAttachShader(program, shader_id);
+			shaders.push_back(shader_id);
+		}
+
+		if (program_cache && GLAD_GL_VERSION_4_1)
+			glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+		// A single link once all the stages are attached
+		bool is_linked = is_compiled;
+
+		if (is_compiled)
+		{
+			glLinkProgram(program);
+			is_linked = checkCompileErrors(program, "PROGRAM");
+		}
+
+		for (GLuint shader_id : shaders)
+		{
+			glDetachShader(program, shader_id);
+			glDeleteShader(shader_id);
+		}
+
+		if (is_linked && program_cache)
+			program_cache->save(program, source_hash);
+
+		return is_linked;
+	}
+
+	static bool checkCompileErrors(GLuint shader, const std::string& type)
 	{
 		int success;
 		char infoLog[1024];
@@ -111,8 +327,98 @@ private:
 				std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
 			}
 		}
+		return success != 0;
+	}
+
+	struct ActiveUniform
+	{
+		std::uint32_t hash;
+		GLint         location;
+		GLenum        type;
+		std::string   name;
+	};
+
+	template <typename T>
+	static constexpr GLenum GetUniformType()
+	{
+		if constexpr (std::is_same_v<T, float>)          return GL_FLOAT;
+		else if constexpr (std::is_same_v<T, glm::vec2>) return GL_FLOAT_VEC2;
+		else if constexpr (std::is_same_v<T, glm::vec3>) return GL_FLOAT_VEC3;
+		else if constexpr (std::is_same_v<T, glm::vec4>) return GL_FLOAT_VEC4;
+		else if constexpr (std::is_same_v<T, glm::mat4>) return GL_FLOAT_MAT4;
+		else                                             return GL_INT; // ints and samplers
+	}
+
+	static void upload(GLint location, float value)            { glUniform1f(location, value); }
+	static void upload(GLint location, int value)              { glUniform1i(location, value); }
+	static void upload(GLint location, const glm::vec2& value) { glUniform2fv(location, 1, glm::value_ptr(value)); }
+	static void upload(GLint location, const glm::vec3& value) { glUniform3fv(location, 1, glm::value_ptr(value)); }
+	static void upload(GLint location, const glm::vec4& value) { glUniform4fv(location, 1, glm::value_ptr(value)); }
+	static void upload(GLint location, const glm::mat4& value) { glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value)); }
+
+	// The hash finds the uniform, the name confirms it
+	const ActiveUniform* findActive(std::uint32_t hash, const char* name) const
+	{
+		auto found = std::lower_bound(active_uniforms.begin(), active_uniforms.end(), hash,
+			[](const ActiveUniform& uniform, std::uint32_t value) { return uniform.hash < value; });
+
+		for (; found != active_uniforms.end() && found->hash == hash; ++found)
+			if (found->name == name)
+				return &*found;
+
+		return nullptr;
+	}
+
+	// Asks the linked program for all of its uniforms, then points the handles at the new locations
+	void reflectUniforms()
+	{
+		active_uniforms.clear();
+
+		GLint count = 0, max_length = 0;
+		glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &count);
+		glGetProgramiv(id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+
+		std::vector<GLchar> buffer(std::max(max_length, 1));
+
+		for (GLint i = 0; i < count; ++i)
+		{
+			GLsizei length = 0;
+			GLint   size   = 0;
+			GLenum  type   = 0;
+			glGetActiveUniform(id, static_cast<GLuint>(i), static_cast<GLsizei>(buffer.size()), &length, &size, &type, buffer.data());
+
+			std::string name(buffer.data(), length);
+
+			// Arrays are reported as "name[0]", they are set through the plain name
+			if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+				name.resize(name.size() - 3);
+
+			const GLint location = glGetUniformLocation(id, name.c_str());
+
+			// Members of uniform blocks have no location and are set through their buffer
+			if (location >= 0)
+				active_uniforms.push_back({ UniformName(name.c_str()).hash, location, type, std::move(name) });
+		}
+
+		// Names with the same hash end up next to each other, findActive tells them apart
+		std::sort(active_uniforms.begin(), active_uniforms.end(), [](const ActiveUniform& a, const ActiveUniform& b) { return a.hash < b.hash; });
+
+		for (std::size_t i = 0; i < handle_hashes.size(); ++i)
+		{
+			const ActiveUniform* active = findActive(handle_hashes[i], handle_names[i].c_str());
+			handle_locations[i] = active ? active->location : -1;
+		}
 	}
 
-	GLuint id;
-	std::map<std::string, GLuint> uniform_locations;
+	static inline ProgramCache* program_cache = nullptr;
+
+	GLuint             id;
+	std::vector<Stage> stages;
+	std::string        defines;
+	bool               is_linked;
+
+	std::vector<ActiveUniform> active_uniforms;  // Sorted by hash
+	std::vector<std::uint32_t> handle_hashes;    // Hashes of the names handed out by getUniform
+	std::vector<std::string>   handle_names;     // The names themselves, to tell colliding hashes apart
+	std::vector<GLint>         handle_locations; // Indexed by Uniform::index
 };
\ No newline at end of file
@@ -0,0 +1,193 @@
+#include "ShaderWatcher.hpp"
+
+#include <iostream>
+#include <system_error>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	// Editors write a file in several steps, the reload waits until it settles
+	constexpr auto SETTLE_TIME = std::chrono::milliseconds(100);
+	constexpr auto POLL_TIME   = std::chrono::milliseconds(250);
+
+	std::filesystem::path Normalize(const std::filesystem::path& path)
+	{
+		std::error_code error;
+		std::filesystem::path result = std::filesystem::weakly_canonical(path, error);
+
+		return error ? path.lexically_normal() : result;
+	}
+}
+
+ShaderWatcher::ShaderWatcher():
+	is_running(true)
+{
+#ifdef __linux__
+	inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+	if (inotify_fd < 0)
+		std::cout << "Shader watcher falls back to polling, inotify is not available\n";
+#endif
+
+	worker = std::thread(&ShaderWatcher::run, this);
+}
+
+ShaderWatcher::~ShaderWatcher()
+{
+	is_running = false;
+	worker.join();
+
+#ifdef __linux__
+	if (inotify_fd >= 0)
+		close(inotify_fd);
+#endif
+}
+
+void ShaderWatcher::watch(ShaderProgram* program)
+{
+	std::vector<std::filesystem::path>& paths = programs[program];
+	paths.clear();
+
+	for (const auto& source_path : program->getSourcePaths())
+	{
+		paths.push_back(Normalize(source_path));
+		addFile(paths.back());
+	}
+}
+
+void ShaderWatcher::unwatch(ShaderProgram* program)
+{
+	programs.erase(program);
+}
+
+void ShaderWatcher::update()
+{
+	std::set<std::filesystem::path> changed_files;
+	{
+		std::lock_guard<std::mutex> lock(files_mutex);
+
+		if (changed.empty() || Clock::now() - last_change < SETTLE_TIME)
+			return;
+
+		changed_files.swap(changed);
+	}
+
+	for (auto& [program, paths] : programs)
+	{
+		bool is_affected = false;
+
+		for (const auto& path : paths)
+			is_affected = is_affected || changed_files.count(path) != 0;
+
+		if (!is_affected)
+			continue;
+
+		if (program->reload())
+			std::cout << "Reloaded shader " << paths.front().filename().string() << '\n';
+		else
+			std::cout << "Shader " << paths.front().filename().string() << " failed to reload, the previous version stays\n";
+	}
+}
+
+void ShaderWatcher::addFile(const std::filesystem::path& path)
+{
+	std::error_code error;
+	const auto write_time = std::filesystem::last_write_time(path, error);
+
+	std::lock_guard<std::mutex> lock(files_mutex);
+
+	if (!files.emplace(path, write_time).second)
+		return;
+
+#ifdef __linux__
+	// Directories are watched rather than files, editors often replace a file instead of writing into it
+	if (inotify_fd >= 0)
+	{
+		const std::filesystem::path directory = path.parent_path();
+
+		for (const auto& [descriptor, watched] : directories)
+			if (watched == directory)
+				return;
+
+		const int descriptor = inotify_add_watch(inotify_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+
+		if (descriptor >= 0)
+			directories.emplace(descriptor, directory);
+	}
+#endif
+}
+
+void ShaderWatcher::onFileChanged(const std::filesystem::path& path)
+{
+	std::lock_guard<std::mutex> lock(files_mutex);
+
+	if (files.count(path))
+	{
+		changed.insert(path);
+		last_change = Clock::now();
+	}
+}
+
+void ShaderWatcher::run()
+{
+	while (is_running)
+	{
+#ifdef __linux__
+		if (inotify_fd >= 0)
+		{
+			pollfd descriptor { inotify_fd, POLLIN, 0 };
+
+			if (poll(&descriptor, 1, static_cast<int>(SETTLE_TIME.count())) <= 0)
+				continue;
+
+			alignas(inotify_event) char buffer[4096];
+			ssize_t length;
+
+			while ((length = read(inotify_fd, buffer, sizeof(buffer))) > 0)
+			{
+				for (char* position = buffer; position < buffer + length;)
+				{
+					const auto* event = reinterpret_cast<const inotify_event*>(position);
+					position += sizeof(inotify_event) + event->len;
+
+					if (!event->len)
+						continue;
+
+					std::filesystem::path directory;
+					{
+						std::lock_guard<std::mutex> lock(files_mutex);
+
+						if (auto found = directories.find(event->wd); found != directories.end())
+							directory = found->second;
+					}
+
+					if (!directory.empty())
+						onFileChanged(directory / event->name);
+				}
+			}
+			continue;
+		}
+#endif
+		std::this_thread::sleep_for(POLL_TIME);
+
+		std::lock_guard<std::mutex> lock(files_mutex);
+
+		for (auto& [path, write_time] : files)
+		{
+			std::error_code error;
+			const auto current_time = std::filesystem::last_write_time(path, error);
+
+			if (!error && current_time != write_time)
+			{
+				write_time  = current_time;
+				changed.insert(path);
+				last_change = Clock::now();
+			}
+		}
+	}
+}
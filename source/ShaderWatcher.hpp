@@ -0,0 +1,55 @@
+#pragma once
+
+#include "ShaderProgram.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Reloads shader programs when their source files change, so shaders can be tuned without a restart.
+// A background thread waits for file changes (inotify on Linux, modification times elsewhere),
+// the GL thread relinks the affected programs in update(). A program that fails to compile is kept
+// as it was and the error is printed.
+class ShaderWatcher
+{
+public:
+	ShaderWatcher();
+	ShaderWatcher(const ShaderWatcher&) = delete;
+	ShaderWatcher& operator = (const ShaderWatcher&) = delete;
+	~ShaderWatcher();
+
+	// The program must outlive the watcher or be unwatched first
+	void watch(ShaderProgram* program);
+	void unwatch(ShaderProgram* program);
+
+	// Relinks the programs whose sources changed. Call once per frame from the GL thread
+	void update();
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	void run();
+	void addFile(const std::filesystem::path& path);
+	void onFileChanged(const std::filesystem::path& path);
+
+	std::map<ShaderProgram*, std::vector<std::filesystem::path>> programs;
+
+	std::mutex                                                files_mutex;
+	std::map<std::filesystem::path, std::filesystem::file_time_type> files; // Watched files and their last write time
+	std::set<std::filesystem::path>                           changed;
+	Clock::time_point                                         last_change;
+
+	std::atomic<bool> is_running;
+	std::thread       worker;
+
+#ifdef __linux__
+	int                               inotify_fd;
+	std::map<int, std::filesystem::path> directories; // Watch descriptor -> directory
+#endif
+};
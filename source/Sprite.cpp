@@ -1,16 +1,38 @@
 #include "Sprite.hpp"
+#include "GLState.hpp"
+#include "ShaderPermutations.hpp"
+#include "Profiler.hpp"
 
+#include <glm/gtc/constants.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <cmath>
+
+static constexpr UniformName MODEL_UNIFORM("model");
+static constexpr UniformName PALETTE_ROW_UNIFORM("palette_row");
+
+// Fixed in the shader by layout (binding = 1)
+static constexpr GLuint PALETTE_UNIT = 1;
+
 Sprite::Sprite():
     VAO(0), VBO(),
     texture(nullptr),
-    color(),
+    color(Color::WHITE),
+    additive(false),
+    tinted(false),
+    alpha_test(false),
+    palette(nullptr),
+    palette_row(0),
     transform_need_update(true),
+    transform(1.0f),
     position(0.0f),
     scale(1.0f),
-    angle(0)
+    angle(0),
+    previous_position(0.0f),
+    previous_scale(1.0f),
+    previous_angle(0),
+    interpolation(1.0f)
 {
     GLfloat vertices[] 
     {
@@ -36,31 +58,63 @@ Sprite::Sprite():
         0.0f, 1.0f
     };
 
+    if (GLState::hasDirectStateAccess())
+    {
+        glCreateVertexArrays(1, &VAO);
+        glCreateBuffers(3, VBO);
+
+        glNamedBufferStorage(VBO[0], sizeof(vertices), vertices, GL_DYNAMIC_STORAGE_BIT);
+        glVertexArrayVertexBuffer(VAO, 0, VBO[0], 0, 2 * sizeof(float));
+        glVertexArrayAttribFormat(VAO, 0, 2, GL_FLOAT, GL_FALSE, 0);
+        glVertexArrayAttribBinding(VAO, 0, 0);
+        glEnableVertexArrayAttrib(VAO, 0);
+
+        glNamedBufferStorage(VBO[1], sizeof(colors), &colors, GL_DYNAMIC_STORAGE_BIT);
+        glVertexArrayVertexBuffer(VAO, 1, VBO[1], 0, 4 * sizeof(float));
+        glVertexArrayAttribFormat(VAO, 1, 4, GL_FLOAT, GL_FALSE, 0);
+        glVertexArrayAttribBinding(VAO, 1, 1);
+        glEnableVertexArrayAttrib(VAO, 1);
+
+        glNamedBufferStorage(VBO[2], sizeof(tex_coords), tex_coords, GL_DYNAMIC_STORAGE_BIT);
+        glVertexArrayVertexBuffer(VAO, 2, VBO[2], 0, 2 * sizeof(float));
+        glVertexArrayAttribFormat(VAO, 2, 2, GL_FLOAT, GL_FALSE, 0);
+        glVertexArrayAttribBinding(VAO, 2, 2);
+        glEnableVertexArrayAttrib(VAO, 2);
+
+        return;
+    }
+
     glGenVertexArrays(1, &VAO);
     glGenBuffers(3, VBO);
 
-    glBindVertexArray(VAO);
+    GLState::bindVertexArray(VAO);
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO[0]);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, VBO[0]);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_DYNAMIC_DRAW);
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), NULL);
     glEnableVertexAttribArray(0);
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO[1]);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, VBO[1]);
     glBufferData(GL_ARRAY_BUFFER, sizeof(colors), &colors, GL_DYNAMIC_DRAW);
     glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), NULL);
     glEnableVertexAttribArray(1);
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO[2]);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, VBO[2]);
     glBufferData(GL_ARRAY_BUFFER, sizeof(tex_coords), tex_coords, GL_DYNAMIC_DRAW);
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), NULL);
     glEnableVertexAttribArray(2);
+
+    if (GLState::unbind_after_use)
+        GLState::bindVertexArray(0);
 }
 
 Sprite::~Sprite()
 {
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(3, VBO);
+
+    GLState::onVertexArrayDeleted(VAO);
+    GLState::onBuffersDeleted(3, VBO);
 }
 
 void Sprite::setTexture(Texture* tex)
@@ -76,9 +130,7 @@ void Sprite::setTexture(Texture* tex)
           w,   h,     
         0.0f,  h 
     };
-    glBindBuffer(GL_ARRAY_BUFFER, VBO[0]);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    GLState::uploadBuffer(GL_ARRAY_BUFFER, VBO[0], 0, sizeof(vertices), vertices);
 
     transform_need_update = true;
 }
@@ -92,9 +144,7 @@ void Sprite::setTextureRect(const glm::fRect& rect)
         rect.width, rect.height,  
         0.0f,       rect.height 
     };
-    glBindBuffer(GL_ARRAY_BUFFER, VBO[0]);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    GLState::uploadBuffer(GL_ARRAY_BUFFER, VBO[0], 0, sizeof(vertices), vertices);
 
     float tex_width  = (float)texture->getSize().x;
     float tex_height = (float)texture->getSize().y;
@@ -111,9 +161,7 @@ void Sprite::setTextureRect(const glm::fRect& rect)
         right, bottom,
         left,  bottom
     };
-    glBindBuffer(GL_ARRAY_BUFFER, VBO[2]);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(tex_coords), tex_coords);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    GLState::uploadBuffer(GL_ARRAY_BUFFER, VBO[2], 0, sizeof(tex_coords), tex_coords);
 
     transform_need_update = true;
 }
@@ -148,18 +196,69 @@ void Sprite::setRotation(float degrees)
 
 void Sprite::setColor(const Color& new_color)
 {
+    color = new_color;
+    updateColor();
+}
+
+void Sprite::setAdditive(bool to_add)
+{
+    additive = to_add;
+    updateColor();
+}
+
+void Sprite::updateColor()
+{
+    // Premultiplied textures need a premultiplied tint. Zero alpha then keeps the color but drops the coverage, which is additive blending
+    Color vertex_color = color;
+
+    if (Texture::isPremultipliedAlpha())
+    {
+        vertex_color.r *= color.a;
+        vertex_color.g *= color.a;
+        vertex_color.b *= color.a;
+
+        if (additive)
+            vertex_color.a = 0.0f;
+    }
+
     Color colors[] =
     {
-        new_color,
-        new_color,
-        new_color,
-        new_color
+        vertex_color,
+        vertex_color,
+        vertex_color,
+        vertex_color
     };
     
-    glBindBuffer(GL_ARRAY_BUFFER, VBO[1]);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(colors), &colors);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    GLState::uploadBuffer(GL_ARRAY_BUFFER, VBO[1], 0, sizeof(colors), &colors);
 
+    tinted = vertex_color != glm::vec4(1.0f);
+}
+
+void Sprite::setAlphaTest(bool enable)
+{
+    alpha_test = enable;
+}
+
+void Sprite::setPalette(Texture* new_palette, int row)
+{
+    palette     = new_palette;
+    palette_row = row;
+}
+
+void Sprite::savePreviousState()
+{
+    previous_position = position;
+    previous_scale    = scale;
+    previous_angle    = angle;
+    transform_need_update = true;
+}
+
+void Sprite::setInterpolation(float alpha)
+{
+    if (interpolation == alpha)
+        return;
+
+    interpolation = alpha;
     transform_need_update = true;
 }
 
@@ -168,6 +267,11 @@ const glm::vec2& Sprite::getPosition() const
     return position;
 }
 
+glm::vec2 Sprite::getInterpolatedPosition() const
+{
+    return glm::mix(previous_position, position, interpolation);
+}
+
 const glm::vec2& Sprite::getScale() const
 {
     return scale;
@@ -183,31 +287,104 @@ const Color& Sprite::getColor() const
     return color;
 }
 
+bool Sprite::isAdditive() const
+{
+    return additive;
+}
+
+std::uint32_t Sprite::getShaderVariant() const
+{
+    std::uint32_t variant = 0;
+
+    if (tinted)
+        variant |= SPRITE_TINT;
+
+    // Palette colors are stored straight as well
+    if (Texture::isPremultipliedAlpha() && (palette || (texture && !texture->isPremultiplied())))
+        variant |= SPRITE_PREMULTIPLY;
+
+    if (alpha_test)
+        variant |= SPRITE_ALPHA_TEST;
+
+    if (palette)
+        variant |= SPRITE_PALETTE_SWAP;
+
+    return variant;
+}
+
 void Sprite::render(ShaderProgram* shader)
 {
-    texture->bind(true);
-    glBindVertexArray(VAO);
+    PROFILE_SCOPE("Sprite::render");
 
+    texture->bind(true);
     shader->use();
 
+    draw(shader);
+
+    texture->bind(false);
+}
+
+void Sprite::submit(RenderQueue& queue, ShaderProgram* shader, std::uint8_t layer)
+{
+    // Inside one layer sprites are ordered by their vertical position
+    std::uint32_t depth = static_cast<std::uint32_t>(glm::clamp(position.y, 0.0f, 16777215.0f));
+
+    RenderCommand command;
+    command.key     = RenderQueue::makeKey(layer, shader->getNativeHandle(), texture->getNativeHandle(), depth);
+    command.shader  = shader;
+    command.texture = texture;
+    command.object  = this;
+    command.draw    = [](void* object, ShaderProgram* program)
+    {
+        static_cast<Sprite*>(object)->draw(program);
+    };
+    queue.submit(command);
+}
+
+void Sprite::submit(RenderQueue& queue, ShaderPermutations& shaders, std::uint8_t layer)
+{
+    // Nothing to draw with while even the plain variant fails to link
+    if (ShaderProgram* shader = shaders.get(getShaderVariant()))
+        submit(queue, shader, layer);
+}
+
+void Sprite::draw(ShaderProgram* shader)
+{
     if (transform_need_update)
     {
-        glm::mat4 transform_matrix(1.0f); 
-        transform_matrix = glm::translate(transform_matrix, glm::vec3(position, 0.0f));
+        const glm::vec2 render_position = getInterpolatedPosition();
+        const glm::vec2 render_scale    = glm::mix(previous_scale, scale, interpolation);
+        // Along the shorter arc: the change is wrapped into [-pi, pi), so 350 to 10 degrees turns by 20
+        const float     turn            = angle - previous_angle;
+        const float     shortest_turn   = turn - glm::two_pi<float>() * std::floor((turn + glm::pi<float>()) / glm::two_pi<float>());
+        const float     render_angle    = previous_angle + shortest_turn * interpolation;
 
-        transform_matrix = glm::translate(transform_matrix, glm::vec3(0.5f * scale.x, 0.5f * scale.x, 0.0f));
-        transform_matrix = glm::rotate(transform_matrix, angle, glm::vec3(0.0f, 0.0f, 1.0f));
-        transform_matrix = glm::translate(transform_matrix, glm::vec3(-0.5f * scale.x, -0.5f * scale.y, 0.0f));
+        transform = glm::mat4(1.0f);
+        transform = glm::translate(transform, glm::vec3(render_position, 0.0f));
 
-        transform_matrix = glm::scale(transform_matrix, glm::vec3(scale, 0.0f));
+        transform = glm::translate(transform, glm::vec3(0.5f * render_scale.x, 0.5f * render_scale.x, 0.0f));
+        transform = glm::rotate(transform, render_angle, glm::vec3(0.0f, 0.0f, 1.0f));
+        transform = glm::translate(transform, glm::vec3(-0.5f * render_scale.x, -0.5f * render_scale.y, 0.0f));
 
-        shader->setUniform("model", glm::value_ptr(transform_matrix));
+        transform = glm::scale(transform, glm::vec3(render_scale, 0.0f));
 
         transform_need_update = false;
     }
+
+    GLState::bindVertexArray(VAO);
+
+    // The program may be shared with other sprites, so the model matrix is uploaded on every draw
+    shader->setUniform(MODEL_UNIFORM, transform);
+
+    if (palette)
+    {
+        GLState::bindTexture(PALETTE_UNIT, palette->getNativeHandle());
+        shader->setUniform(PALETTE_ROW_UNIFORM, (palette_row + 0.5f) / palette->getSize().y);
+    }
         
     glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+    GLState::onDraw(2);
 
-    texture->bind(false);
-    glBindVertexArray(0);
+    if (GLState::unbind_after_use)
+        GLState::bindVertexArray(0);
 }
\ No newline at end of file
@@ -9,10 +9,28 @@
 #include "Color.hpp"
 #include "ShaderProgram.hpp"
 #include "Rectangle.hpp"
+#include "RenderQueue.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class ShaderPermutations;
+
+// Features of the sprite shader, bit i is the define SHADER_FEATURES[i] (see ShaderPermutations)
+enum SpriteShaderFeature : std::uint32_t
+{
+    SPRITE_TINT         = 1 << 0, // Vertex color multiply, white sprites skip it
+    SPRITE_PREMULTIPLY  = 1 << 1, // Straight alpha texture under premultiplied blending
+    SPRITE_ALPHA_TEST   = 1 << 2, // Discards texels below half coverage
+    SPRITE_PALETTE_SWAP = 1 << 3  // Red channel picks a color from a palette row
+};
 
 class Sprite
 {
 public:
+    static inline const std::vector<std::string> SHADER_FEATURES { "TINT", "PREMULTIPLY", "ALPHA_TEST", "PALETTE_SWAP" };
+
     Sprite();
     ~Sprite();
 
@@ -24,21 +42,56 @@ public:
     void setScale(float factorX, float factorY);
     void setRotation(float degrees);
     void setColor(const Color& new_color);
+    // Adds the sprite onto what's behind it, in the same batch as alpha blended sprites.
+    // Needs premultiplied alpha (see Texture::setPremultipliedAlpha)
+    void setAdditive(bool additive);
+    void setAlphaTest(bool alpha_test);
+    // Every row of the palette texture is a color set, the sprite texture's red channel picks the column.
+    // Texels of such textures must be opaque or fully transparent. nullptr turns it off
+    void setPalette(Texture* new_palette, int row = 0);
+
+    // Fixed timestep support (see GameLoop): the sprite is drawn between the state saved at the start
+    // of the last simulation step and the current one. Without it the current state is drawn
+    void savePreviousState();
+    void setInterpolation(float alpha);
 
     const glm::vec2& getPosition() const;
+    // Where the sprite is drawn, between the previous and the current position
+    glm::vec2        getInterpolatedPosition() const;
     const glm::vec2& getScale()    const;
     const float      getRotation() const;
     const Color&     getColor()    const;
+    bool             isAdditive()  const;
+    // The cheapest sprite shader variant that draws this sprite correctly
+    std::uint32_t    getShaderVariant() const;
 
     void render(ShaderProgram* shader);
+    void submit(RenderQueue& queue, ShaderProgram* shader, std::uint8_t layer);
+    void submit(RenderQueue& queue, ShaderPermutations& shaders, std::uint8_t layer);
+    // Issues the draw call only, the shader and the texture must be bound already
+    void draw(ShaderProgram* shader);
 
 private:  
+    void updateColor();
+
     GLuint VAO, VBO[3];
     Texture* texture; 
     Color color;
+    bool  additive;
+    bool  tinted;
+    bool  alpha_test;
+
+    Texture* palette;
+    int      palette_row;
 
     bool transform_need_update;
+    glm::mat4 transform;
     glm::vec2 position;
     glm::vec2 scale;
     float     angle;
+
+    glm::vec2 previous_position;
+    glm::vec2 previous_scale;
+    float     previous_angle;
+    float     interpolation;
 };
@@ -0,0 +1,82 @@
+#include "SpriteBatch.hpp"
+
+#include <cstddef>
+
+SpriteBatch::SpriteBatch(Texture* texture):
+	texture(texture),
+	instances({
+		{ 4, GL_FLOAT, offsetof(SpriteInstance, bounds) },
+		{ 4, GL_FLOAT, offsetof(SpriteInstance, uv_rect) },
+		{ 4, GL_FLOAT, offsetof(SpriteInstance, color) }
+	})
+{
+}
+
+SpriteBatch::InstanceId SpriteBatch::add(const glm::vec2& position, const glm::fRect& texture_rect, const Color& color)
+{
+	const InstanceId id = instances.add();
+
+	setPosition(id, position);
+	setTextureRect(id, texture_rect);
+	setColor(id, color);
+
+	return id;
+}
+
+void SpriteBatch::clear()
+{
+	instances.clear();
+}
+
+void SpriteBatch::setPosition(InstanceId id, const glm::vec2& position)
+{
+	SpriteInstance& instance = instances.edit(id);
+	instance.bounds.x = position.x;
+	instance.bounds.y = position.y;
+}
+
+void SpriteBatch::setTextureRect(InstanceId id, const glm::fRect& rect)
+{
+	const glm::vec2 texture_size = texture->getSize();
+
+	SpriteInstance& instance = instances.edit(id);
+	instance.bounds.z = rect.width;
+	instance.bounds.w = rect.height;
+	instance.uv_rect  = glm::vec4(rect.left, rect.top, rect.left + rect.width, rect.top + rect.height) /
+		                glm::vec4(texture_size, texture_size);
+}
+
+void SpriteBatch::setColor(InstanceId id, const Color& color)
+{
+	instances.edit(id).color = GetInstanceColor(color);
+}
+
+const SpriteInstance& SpriteBatch::getInstance(InstanceId id) const
+{
+	return instances.get(id);
+}
+
+std::size_t SpriteBatch::getInstanceCount() const
+{
+	return instances.size();
+}
+
+Texture* SpriteBatch::getTexture() const
+{
+	return texture;
+}
+
+void SpriteBatch::upload()
+{
+	instances.upload();
+}
+
+void SpriteBatch::submit(RenderQueue& queue, ShaderProgram* shader, std::uint8_t layer)
+{
+	instances.submit(queue, shader, texture, layer);
+}
+
+void SpriteBatch::draw(ShaderProgram*)
+{
+	instances.draw();
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include "Texture.hpp"
+#include "Color.hpp"
+#include "Rectangle.hpp"
+#include "ShaderProgram.hpp"
+#include "RenderQueue.hpp"
+#include "InstanceBuffer.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Per instance vertex data, one quad each
+struct SpriteInstance
+{
+	glm::vec4 bounds;  // Position xy, size zw, in pixels
+	glm::vec4 uv_rect; // Left, top, right, bottom, normalized
+	glm::vec4 color;
+};
+
+// Many unrotated sprites of one texture drawn with a single instanced call (res/shaders/sprite_batch.*).
+// Setters only write the CPU copy (see InstanceBuffer), so code that updates instances
+// (e.g. AnimationSystem) needs no GL at all.
+class SpriteBatch
+{
+public:
+	using InstanceId = InstanceBuffer<SpriteInstance>::InstanceId;
+
+	explicit SpriteBatch(Texture* texture);
+	SpriteBatch(const SpriteBatch&) = delete;
+	SpriteBatch& operator = (const SpriteBatch&) = delete;
+
+	// Instances live until clear(), their ids are indices
+	InstanceId add(const glm::vec2& position, const glm::fRect& texture_rect, const Color& color = Color::WHITE);
+	void clear();
+
+	void setPosition(InstanceId id, const glm::vec2& position);
+	// In pixels of the texture, the quad takes the size of the rect
+	void setTextureRect(InstanceId id, const glm::fRect& rect);
+	void setColor(InstanceId id, const Color& color);
+
+	const SpriteInstance& getInstance(InstanceId id) const;
+	std::size_t           getInstanceCount() const;
+	Texture*              getTexture() const;
+
+	// Sends the instances changed since the last upload. Called by draw, GL thread only
+	void upload();
+
+	void submit(RenderQueue& queue, ShaderProgram* shader, std::uint8_t layer);
+	// Issues the draw call only, the shader and the texture must be bound already
+	void draw(ShaderProgram* shader);
+
+private:
+	Texture*                       texture;
+	InstanceBuffer<SpriteInstance> instances;
+};
@@ -1,102 +1,449 @@
 #include "Texture.hpp"
+#include "GLState.hpp"
+#include "TextureCache.hpp"
+#include "Ktx2.hpp"
+#include "ImageCache.hpp"
+#include "Profiler.hpp"
 
 #include <iostream>
-#include <map>
+#include <algorithm>
+#include <vector>
 
-Texture::Texture() : id(0), size(0)
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+
+ImageCache* Texture::image_cache = nullptr;
+bool Texture::premultiplied_alpha = false;
+
+// Cached decodes of one file are kept apart by the processing they went through
+static constexpr std::uint32_t PREMULTIPLIED_VARIANT = 1;
+
+Texture::Texture() : id(0), size(0), format(GL_RGBA), internal_format(GL_RGBA8), levels(1), level_limit(0), mip_policy(MipPolicy::None), premultiplied(false)
 {
 }
 
 Texture::~Texture()
 {
-    if(id) glDeleteTextures(1, &id);
+    if (id)
+    {
+        glDeleteTextures(1, &id);
+        GLState::onTextureDeleted(id);
+    }
 }
 
 bool Texture::loadFromFile(const std::string& file_path)
 {
-    if (id) glDeleteTextures(1, &id);
+    PROFILE_SCOPE("Texture::loadFromFile");
 
-    glGenTextures(1, &id);
+    if (file_path.size() > 5 && file_path.compare(file_path.size() - 5, 5, ".ktx2") == 0)
+        return loadFromKtx2(file_path);
 
-    setRepeated(false);
-    setSmooth(false);
+    DecodedImage image;
+
+    if (decodeImage(file_path, image))
+        return loadPixels(image.getPixels(), image.getWidth(), image.getHeight(), image.getChannels());
+
+    std::cout << "Failed to load texture " + file_path + '\n';
+    return false;
+}
+
+bool Texture::loadTileset(const std::string& file_path, const TileLayout& layout)
+{
+    DecodedImage image;
+
+    if (!decodeImage(file_path, image))
+    {
+        std::cout << "Failed to load texture " + file_path + '\n';
+        return false;
+    }
+
+    int width, height;
+    GetExtrudedSize(image.getWidth(), image.getHeight(), layout, width, height);
+
+    std::vector<unsigned char> pixels = ExtrudeTiles(image.getPixels(), image.getWidth(), image.getHeight(), image.getChannels(), layout);
+
+    if (layout.border > 0)
+        setLevelLimit(GetProtectedLevelCount(layout));
+
+    return loadPixels(pixels.data(), width, height, image.getChannels());
+}
 
-    int width, height, channels;
-    unsigned char* data = stbi_load(file_path.c_str(), &width, &height, &channels, 0);
+bool Texture::loadFromKtx2(const std::string& file_path)
+{
+    Ktx2Image image;
+
+    if (!LoadKtx2(file_path, image))
+        return false;
+
+    const GLsizei level_count = level_limit > 0 ? std::min(static_cast<GLsizei>(image.levels.size()), level_limit) : static_cast<GLsizei>(image.levels.size());
+    mip_policy = level_count > 1 ? MipPolicy::Precomputed : MipPolicy::None;
+
+    // Blocks go to GL as they are stored. Without driver support they are decoded here instead
+    GLenum compressed_format = 0;
+
+    if (GLAD_GL_VERSION_4_2)
+    {
+        if (image.format == BlockFormat::BC7)
+            compressed_format = GL_COMPRESSED_RGBA_BPTC_UNORM;
+        else if (image.format == BlockFormat::BC1 && GLState::hasExtension("GL_EXT_texture_compression_s3tc"))
+            compressed_format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+    }
+
+    const GLenum storage_format = compressed_format ? compressed_format : GL_RGBA8;
+
+    // Decoded blocks can still be converted here, the compressed ones have to be baked with --premultiply
+    const bool to_premultiply = premultiplied_alpha && !image.premultiplied;
+
+    // Sprites convert the compressed ones in the shader instead (see SPRITE_PREMULTIPLY)
+    if (to_premultiply && compressed_format)
+        std::cout << "Texture " + file_path + " has straight alpha, bake it with --premultiply to skip the conversion in the shader\n";
+
+    if (!allocate(image.width, image.height, storage_format, level_count))
+        return false;
 
-    size = { width, height };
+    format        = GL_RGBA;
+    premultiplied = image.premultiplied || (to_premultiply && !compressed_format);
 
-    GLenum mode = channels == 4 ? GL_RGBA : GL_RGB;
+    for (GLsizei level = 0; level < level_count; ++level)
+    {
+        const int level_width  = std::max(int(image.width  >> level), 1);
+        const int level_height = std::max(int(image.height >> level), 1);
+
+        if (compressed_format)
+        {
+            const GLsizei bytes = static_cast<GLsizei>(image.levels[level].size);
+
+            if (GLState::hasDirectStateAccess())
+            {
+                glCompressedTextureSubImage2D(id, level, 0, 0, level_width, level_height, compressed_format, bytes, image.getLevelData(level));
+            }
+            else
+            {
+                bind(true);
+                glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, level_width, level_height, compressed_format, bytes, image.getLevelData(level));
+                bind(false);
+            }
+        }
+        else
+        {
+            std::vector<unsigned char> pixels = DecompressImage(image.getLevelData(level), level_width, level_height, image.format);
 
-    if (data)
+            if (to_premultiply)
+                PremultiplyAlpha(pixels.data(), pixels.size() / 4);
+
+            update(pixels.data(), 0, 0, level_width, level_height, level);
+        }
+    }
+    return true;
+}
+
+bool Texture::loadFromMemory(const unsigned char* pixels, int width, int height, int channels)
+{
+    if (pixels && premultiplied_alpha && channels == 4)
+    {
+        std::vector<unsigned char> premultiplied(pixels, pixels + std::size_t(width) * height * 4);
+        PremultiplyAlpha(premultiplied.data(), premultiplied.size() / 4);
+
+        return loadPixels(premultiplied.data(), width, height, channels);
+    }
+
+    return loadPixels(pixels, width, height, channels);
+}
+
+bool Texture::loadPixels(const unsigned char* pixels, int width, int height, int channels)
+{
+    if (!pixels || !allocate(width, height, channels))
+        return false;
+
+    update(pixels, 0, 0, width, height);
+    generateMipmap();
+
+    return true;
+}
+
+bool Texture::create(int width, int height, int channels)
+{
+    if (!allocate(width, height, channels))
+        return false;
+
+    if (GLState::hasDirectStateAccess())
+    {
+        GLubyte transparent[4] {};
+        glClearTexImage(id, 0, GL_RGBA, GL_UNSIGNED_BYTE, transparent);
+    }
+    else
+    {
+        std::vector<GLubyte> transparent(std::size_t(width) * height * channels, 0);
+        update(transparent.data(), 0, 0, width, height);
+    }
+    return true;
+}
+
+void Texture::update(const unsigned char* pixels, int x, int y, int width, int height, int level)
+{
+    // RGB rows are not always 4-byte aligned
+    bool is_aligned = (width * (format == GL_RGBA ? 4 : 3)) % 4 == 0;
+
+    if (!is_aligned)
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    if (GLState::hasDirectStateAccess())
+    {
+        glTextureSubImage2D(id, level, x, y, width, height, format, GL_UNSIGNED_BYTE, pixels);
+    }
+    else
     {
         bind(true);
-        glTexImage2D(GL_TEXTURE_2D, 0, mode, width, height, 0, mode, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexSubImage2D(GL_TEXTURE_2D, level, x, y, width, height, format, GL_UNSIGNED_BYTE, pixels);
         bind(false);
+    }
 
-        stbi_image_free(data);      
-        return true;
+    if (!is_aligned)
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void Texture::generateMipmap()
+{
+    if (mip_policy != MipPolicy::Generate || levels == 1)
+        return;
+
+    if (GLState::hasDirectStateAccess())
+    {
+        glGenerateTextureMipmap(id);
+    }
+    else
+    {
+        bind(true);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        bind(false);
     }
-    std::cout << "Failed to load texture " + file_path + '\n';
-    return false;
 }
 
 void Texture::bind(bool to_bind)
 {
-    to_bind ? glBindTexture(GL_TEXTURE_2D, id) : glBindTexture(GL_TEXTURE_2D, 0);;
+    if (to_bind)
+        GLState::bindTexture(0, id);
+    else if (GLState::unbind_after_use)
+        GLState::bindTexture(0, 0);
 }
 
 void Texture::setRepeated(bool repeat)
 {
-    bind(true);
-
     if (repeat)
     {
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        setParameter(GL_TEXTURE_WRAP_S, GL_REPEAT);
+        setParameter(GL_TEXTURE_WRAP_T, GL_REPEAT);
     }
     else
     {
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+        setParameter(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+        setParameter(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
 
         float border_color[] { 1.0f, 1.0f, 1.0f, 1.0f };
-        glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border_color);
+
+        if (GLState::hasDirectStateAccess())
+        {
+            glTextureParameterfv(id, GL_TEXTURE_BORDER_COLOR, border_color);
+        }
+        else
+        {
+            bind(true);
+            glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border_color);
+            bind(false);
+        }
     }
-    bind(false);
 }
 
 void Texture::setSmooth(bool smooth)
 {
-    bind(true);
-
     if (smooth)
     {
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        setParameter(GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        setParameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     }
     else
     {
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        setParameter(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        setParameter(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+}
+
+void Texture::setParameter(GLenum name, GLint value)
+{
+    if (GLState::hasDirectStateAccess())
+    {
+        glTextureParameteri(id, name, value);
+        return;
     }
+
+    bind(true);
+    glTexParameteri(GL_TEXTURE_2D, name, value);
     bind(false);
 }
 
+bool Texture::allocate(int width, int height, int channels)
+{
+    if (channels != 3 && channels != 4)
+        return false;
+
+    GLsizei level_count = 1;
+
+    if (mip_policy != MipPolicy::None)
+        for (int side = std::max(width, height); side > 1; side >>= 1)
+            level_count++;
+
+    if (level_limit > 0)
+        level_count = std::min(level_count, level_limit);
+
+    if (!allocate(width, height, channels == 4 ? GL_RGBA8 : GL_RGB8, level_count))
+        return false;
+
+    format = channels == 4 ? GL_RGBA : GL_RGB;
+
+    return true;
+}
+
+bool Texture::allocate(int width, int height, GLenum storage_format, GLsizei level_count)
+{
+    if (width <= 0 || height <= 0 || level_count <= 0)
+        return false;
+
+    if (id)
+    {
+        glDeleteTextures(1, &id);
+        GLState::onTextureDeleted(id);
+    }
+
+    if (GLState::hasDirectStateAccess())
+        glCreateTextures(GL_TEXTURE_2D, 1, &id);
+    else
+        glGenTextures(1, &id);
+
+    size            = { width, height };
+    internal_format = storage_format;
+    levels          = level_count;
+    premultiplied   = premultiplied_alpha;
+
+    setRepeated(false);
+    setSmooth(false);
+    setParameter(GL_TEXTURE_MAX_LEVEL, levels - 1);
+
+    // Immutable storage lets the driver skip the completeness checks of every level
+    if (GLState::hasDirectStateAccess())
+    {
+        glTextureStorage2D(id, levels, internal_format, width, height);
+    }
+    else if (GLAD_GL_VERSION_4_2)
+    {
+        bind(true);
+        glTexStorage2D(GL_TEXTURE_2D, levels, internal_format, width, height);
+        bind(false);
+    }
+    else
+    {
+        bind(true);
+        for (GLsizei level = 0; level < levels; ++level)
+            glTexImage2D(GL_TEXTURE_2D, level, internal_format, std::max(width >> level, 1), std::max(height >> level, 1), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        bind(false);
+    }
+    return true;
+}
+
 const glm::uvec2 Texture::getSize() const
 {
     return size;
 }
 
-Texture* GetTexture(const std::string_view file_name)
+GLuint Texture::getNativeHandle() const
 {
-    static std::map<std::string_view, Texture> textures;
+    return id;
+}
 
-    if (auto found = textures.find(file_name); found != textures.end())
-        return &found->second;
-    else  
-        textures[file_name].loadFromFile(std::string(file_name));  
+void Texture::setImageCache(ImageCache* cache)
+{
+    image_cache = cache;
+}
+
+ImageCache* Texture::getImageCache()
+{
+    return image_cache;
+}
+
+void Texture::setPremultipliedAlpha(bool premultiplied)
+{
+    premultiplied_alpha = premultiplied;
+}
+
+bool Texture::isPremultipliedAlpha()
+{
+    return premultiplied_alpha;
+}
+
+bool Texture::isPremultiplied() const
+{
+    return premultiplied;
+}
+
+bool Texture::decodeImage(const std::string& file_path, DecodedImage& image, int desired_channels)
+{
+    PROFILE_SCOPE("Texture::decodeImage");
+
+    const ImageTransform transform = premultiplied_alpha ? static_cast<ImageTransform>(PremultiplyAlpha) : nullptr;
+
+    if (image_cache)
+        return image_cache->load(file_path, image, desired_channels, premultiplied_alpha ? PREMULTIPLIED_VARIANT : 0, transform);
+
+    return image.loadFromFile(file_path, desired_channels, transform);
+}
+
+std::size_t Texture::getMemorySize() const
+{
+    if (!id) return 0;
+
+    std::size_t bytes = 0;
+
+    for (GLsizei level = 0; level < levels; ++level)
+    {
+        const std::size_t width  = std::max(size.x >> level, 1u);
+        const std::size_t height = std::max(size.y >> level, 1u);
+
+        switch (internal_format)
+        {
+            case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT: bytes += GetImageSize(BlockFormat::BC1, width, height); break;
+            case GL_COMPRESSED_RGBA_BPTC_UNORM:    bytes += GetImageSize(BlockFormat::BC7, width, height); break;
+            case GL_RGB8:                          bytes += width * height * 3; break;
+            default:                               bytes += width * height * 4; break;
+        }
+    }
+
+    return bytes;
+}
+
+void Texture::setMipPolicy(MipPolicy policy)
+{
+    mip_policy = policy;
+}
+
+void Texture::setLevelLimit(int limit)
+{
+    level_limit = std::max(limit, 0);
+}
+
+Texture::MipPolicy Texture::getMipPolicy() const
+{
+    return mip_policy;
+}
+
+int Texture::getLevelCount() const
+{
+    return levels;
+}
+
+Texture* GetTexture(const std::string_view file_name)
+{
+    // Textures requested here are held for the whole program run
+    static TextureCache textures;
 
-    return &textures[file_name];
+    return textures.get(textures.acquire(file_name));
 }
\ No newline at end of file
@@ -4,25 +4,86 @@
 #include "stb_image.h"
 #include <glm/glm.hpp>
 
+#include "ImageOperations.hpp"
+
+#include <cstddef>
 #include <string>
 #include <string_view>
 
+class ImageCache;
+class DecodedImage;
+
 class Texture
 {
 public:
+    // How the mip chain is filled. Nearest filtered pixel art never samples it, so it has none by default
+    enum class MipPolicy
+    {
+        None,        // Single level
+        Generate,    // Full chain built by GL from level 0
+        Precomputed  // Full chain, every level uploaded by the caller through update()
+    };
 
     Texture();
     ~Texture();
 
+    // Files ending with .ktx2 are loaded through loadFromKtx2
     bool loadFromFile(const std::string& file_path);
+    // Re-lays out the tileset with extruded tiles (see ExtrudeTiles), pass the same border to TileMap::load
+    bool loadTileset(const std::string& file_path, const TileLayout& layout);
+    // Uploads pre-compressed blocks (see TextureBaker) without decoding them
+    bool loadFromKtx2(const std::string& file_path);
+    // Pixels are tightly packed rows of RGB (3 channels) or RGBA (4 channels) bytes with straight alpha
+    bool loadFromMemory(const unsigned char* pixels, int width, int height, int channels);
+    // Allocates storage without pixels, the contents are cleared to transparent black
+    bool create(int width, int height, int channels);
+    // Pixels go to GL as they are, premultiplied already if the mode is on.
+    // With a buffer bound to GL_PIXEL_UNPACK_BUFFER pixels is an offset into that buffer
+    void update(const unsigned char* pixels, int x, int y, int width, int height, int level = 0);
+    // Rebuilds the mip chain, does nothing unless the policy is Generate
+    void generateMipmap();
+    // Takes effect on the next load or create
+    void setMipPolicy(MipPolicy policy);
+    MipPolicy getMipPolicy() const;
+    // Caps the mip chain of the next load or create, zero for no limit. Extruded tilesets keep the levels their border protects
+    void setLevelLimit(int limit);
+    int getLevelCount() const;
     void bind(bool to_bind);
     void setRepeated(bool repeat);
     void setSmooth(bool smooth);
     const glm::uvec2 getSize() const;
+    GLuint getNativeHandle() const;
+
+    // When set, images loaded from files go through this disk cache of decoded pixels
+    static void setImageCache(ImageCache* cache);
+    static ImageCache* getImageCache();
+    // Opt-in: textures loaded afterwards store color multiplied by alpha, to be drawn with glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA)
+    static void setPremultipliedAlpha(bool premultiplied);
+    static bool isPremultipliedAlpha();
+    // Color of this texture is multiplied by alpha. Only compressed KTX2 files baked without --premultiply differ from the mode
+    bool isPremultiplied() const;
+    // Decodes a file the way loadFromFile does: through the image cache and premultiplied when the mode is on
+    static bool decodeImage(const std::string& file_path, DecodedImage& image, int desired_channels = 0);
+    // Video memory taken by all mip levels, in bytes
+    std::size_t getMemorySize() const;
 
 private:
+    bool loadPixels(const unsigned char* pixels, int width, int height, int channels);
+    bool allocate(int width, int height, int channels);
+    bool allocate(int width, int height, GLenum storage_format, GLsizei level_count);
+    void setParameter(GLenum name, GLint value);
+
     GLuint id;
     glm::uvec2 size;
+    static ImageCache* image_cache;
+    static bool premultiplied_alpha;
+
+    GLenum format;
+    GLenum internal_format;
+    GLsizei levels;
+    GLsizei level_limit;
+    MipPolicy mip_policy;
+    bool premultiplied;
 };
 
 Texture* GetTexture(const std::string_view file_name);
\ No newline at end of file
@@ -0,0 +1,351 @@
+#include "TextureAtlas.hpp"
+#include "ImageOperations.hpp"
+
+#include "stb_image.h"
+#include "stb_image_write.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cstring>
+
+AtlasPacker::AtlasPacker(unsigned width, unsigned height):
+	size(width, height)
+{
+	clear();
+}
+
+bool AtlasPacker::insert(unsigned width, unsigned height, glm::uvec2& position)
+{
+	std::size_t best_index  = skyline.size();
+	unsigned    best_bottom = 0xFFFFFFFF;
+	unsigned    best_width  = 0xFFFFFFFF;
+	unsigned    best_y      = 0;
+
+	for (std::size_t i = 0; i < skyline.size(); ++i)
+	{
+		unsigned y = 0;
+
+		if (fits(i, width, height, y))
+		{
+			unsigned bottom = y + height;
+
+			if (bottom < best_bottom || (bottom == best_bottom && skyline[i].width < best_width))
+			{
+				best_index  = i;
+				best_bottom = bottom;
+				best_width  = skyline[i].width;
+				best_y      = y;
+			}
+		}
+	}
+
+	if (best_index == skyline.size())
+		return false;
+
+	position = { skyline[best_index].x, best_y };
+
+	// Raise the skyline under the new rectangle
+	skyline.insert(skyline.begin() + best_index, { position.x, best_bottom, width });
+
+	for (std::size_t i = best_index + 1; i < skyline.size();)
+	{
+		Segment& previous = skyline[i - 1];
+		Segment& current  = skyline[i];
+		unsigned previous_end = previous.x + previous.width;
+
+		if (current.x >= previous_end)
+			break;
+
+		unsigned shrink = previous_end - current.x;
+
+		if (current.width <= shrink)
+		{
+			skyline.erase(skyline.begin() + i);
+			continue;
+		}
+
+		current.x     += shrink;
+		current.width -= shrink;
+		break;
+	}
+
+	// Merge neighbours of equal height
+	for (std::size_t i = 1; i < skyline.size();)
+	{
+		if (skyline[i - 1].y == skyline[i].y)
+		{
+			skyline[i - 1].width += skyline[i].width;
+			skyline.erase(skyline.begin() + i);
+		}
+		else ++i;
+	}
+	return true;
+}
+
+void AtlasPacker::clear()
+{
+	skyline.clear();
+	skyline.push_back({ 0, 0, size.x });
+}
+
+const glm::uvec2& AtlasPacker::getSize() const
+{
+	return size;
+}
+
+bool AtlasPacker::fits(std::size_t index, unsigned width, unsigned height, unsigned& y) const
+{
+	if (skyline[index].x + width > size.x)
+		return false;
+
+	y = 0;
+	unsigned width_left = width;
+
+	for (std::size_t i = index; width_left > 0; ++i)
+	{
+		if (i == skyline.size())
+			return false;
+
+		y = std::max(y, skyline[i].y);
+
+		if (y + height > size.y)
+			return false;
+
+		width_left -= std::min(width_left, skyline[i].width);
+	}
+	return true;
+}
+
+TextureAtlas::TextureAtlas(unsigned page_width, unsigned page_height, unsigned padding):
+	page_size(page_width, page_height), padding(padding)
+{
+}
+
+bool TextureAtlas::addImage(const std::string& name, const std::string& file_path)
+{
+	int width, height, channels;
+	unsigned char* data = stbi_load(file_path.c_str(), &width, &height, &channels, 4);
+
+	if (!data)
+	{
+		std::cout << "Failed to load atlas image " + file_path + '\n';
+		return false;
+	}
+
+	bool added = addImage(name, data, width, height);
+	stbi_image_free(data);
+
+	return added;
+}
+
+bool TextureAtlas::addImage(const std::string& name, const unsigned char* rgba_pixels, unsigned width, unsigned height)
+{
+	if (width + 2 * padding > page_size.x || height + 2 * padding > page_size.y)
+	{
+		std::cout << "Image " + name + " is larger than an atlas page\n";
+		return false;
+	}
+
+	Image image;
+	image.name   = name;
+	image.width  = width;
+	image.height = height;
+	image.pixels.assign(rgba_pixels, rgba_pixels + std::size_t(width) * height * 4);
+
+	images.emplace_back(std::move(image));
+
+	return true;
+}
+
+bool TextureAtlas::pack()
+{
+	// Tall images first, this keeps the skyline flat
+	std::vector<const Image*> order;
+	order.reserve(images.size());
+
+	for (const auto& image : images)
+		order.push_back(&image);
+
+	std::stable_sort(order.begin(), order.end(), [](const Image* a, const Image* b)
+		{
+			return a->height != b->height ? a->height > b->height : a->width > b->width;
+		});
+
+	pages.clear();
+	regions.clear();
+
+	std::vector<AtlasPacker> packers;
+
+	for (const Image* image : order)
+	{
+		glm::uvec2 position;
+		std::size_t page = 0;
+
+		for (; page < packers.size(); ++page)
+			if (packers[page].insert(image->width + 2 * padding, image->height + 2 * padding, position))
+				break;
+
+		if (page == packers.size())
+		{
+			packers.emplace_back(page_size.x, page_size.y);
+			pages.emplace_back(std::size_t(page_size.x) * page_size.y * 4, 0);
+
+			if (!packers.back().insert(image->width + 2 * padding, image->height + 2 * padding, position))
+				return false;
+		}
+
+		// The padding repeats the image edges, so filtered sampling at the region border picks up no neighbours
+		const TileLayout layout { int(image->width), int(image->height), int(padding) };
+		const std::vector<unsigned char> extruded = ExtrudeTiles(image->pixels.data(), image->width, image->height, 4, layout);
+
+		unsigned char* destination = pages[page].data();
+		const std::size_t row_size = std::size_t(image->width + 2 * padding) * 4;
+
+		for (unsigned row = 0; row < image->height + 2 * padding; ++row)
+			std::memcpy(destination + ((std::size_t(position.y) + row) * page_size.x + position.x) * 4,
+				        extruded.data() + row * row_size, row_size);
+
+		AtlasRegion region;
+		region.page = page;
+		region.rect = glm::fRect(float(position.x + padding), float(position.y + padding), float(image->width), float(image->height));
+		regions[image->name] = region;
+	}
+	return true;
+}
+
+bool TextureAtlas::upload()
+{
+	textures.clear();
+
+	for (const auto& page : pages)
+	{
+		auto texture = std::make_unique<Texture>();
+
+		if (!texture->loadFromMemory(page.data(), page_size.x, page_size.y, 4))
+			return false;
+
+		textures.emplace_back(std::move(texture));
+	}
+	return true;
+}
+
+bool TextureAtlas::saveToFile(const std::string& path) const
+{
+	std::ofstream descriptor(path + ".atlas");
+
+	if (!descriptor.is_open())
+	{
+		std::cout << "Failed to write atlas " + path + ".atlas\n";
+		return false;
+	}
+
+	for (std::size_t i = 0; i < pages.size(); ++i)
+	{
+		std::string page_path = path + '_' + std::to_string(i) + ".png";
+
+		if (!stbi_write_png(page_path.c_str(), page_size.x, page_size.y, 4, pages[i].data(), page_size.x * 4))
+		{
+			std::cout << "Failed to write atlas page " + page_path + '\n';
+			return false;
+		}
+
+		// Pages are stored relative to the descriptor
+		descriptor << "page " << page_path.substr(page_path.find_last_of("/\\") + 1) << '\n';
+	}
+
+	for (const auto& [name, region] : regions)
+		descriptor << "region " << region.page << ' '
+		           << region.rect.left << ' ' << region.rect.top << ' '
+		           << region.rect.width << ' ' << region.rect.height << ' '
+		           << name << '\n';
+
+	return true;
+}
+
+bool TextureAtlas::loadFromFile(const std::string& descriptor_path)
+{
+	std::ifstream descriptor(descriptor_path);
+
+	if (!descriptor.is_open())
+	{
+		std::cout << "Failed to open atlas " + descriptor_path + '\n';
+		return false;
+	}
+
+	std::string directory = descriptor_path.substr(0, descriptor_path.find_last_of("/\\") + 1);
+
+	images.clear();
+	pages.clear();
+	textures.clear();
+	regions.clear();
+
+	std::string line;
+
+	while (std::getline(descriptor, line))
+	{
+		std::istringstream stream(line);
+		std::string tag;
+		stream >> tag;
+
+		if (tag == "page")
+		{
+			std::string file_name;
+			stream >> file_name;
+
+			auto texture = std::make_unique<Texture>();
+
+			if (!texture->loadFromFile(directory + file_name))
+				return false;
+
+			page_size = texture->getSize();
+			textures.emplace_back(std::move(texture));
+		}
+		else if (tag == "region")
+		{
+			AtlasRegion region;
+			stream >> region.page >> region.rect.left >> region.rect.top >> region.rect.width >> region.rect.height;
+
+			std::string name;
+			std::getline(stream >> std::ws, name);
+
+			regions[name] = region;
+		}
+	}
+	return true;
+}
+
+const AtlasRegion* TextureAtlas::getRegion(const std::string& name) const
+{
+	if (auto found = regions.find(name); found != regions.end())
+		return &found->second;
+
+	return nullptr;
+}
+
+glm::fRect TextureAtlas::getRect(const std::string& name) const
+{
+	if (auto region = getRegion(name))
+		return region->rect;
+
+	return glm::fRect();
+}
+
+Texture* TextureAtlas::getTexture(std::size_t page) const
+{
+	return page < textures.size() ? textures[page].get() : nullptr;
+}
+
+Texture* TextureAtlas::getTexture(const std::string& name) const
+{
+	if (auto region = getRegion(name))
+		return getTexture(region->page);
+
+	return nullptr;
+}
+
+std::size_t TextureAtlas::getPageCount() const
+{
+	return std::max(pages.size(), textures.size());
+}
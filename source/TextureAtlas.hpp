@@ -0,0 +1,89 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "Texture.hpp"
+#include "Rectangle.hpp"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+
+// Skyline bottom-left bin packer. Works on sizes only, so it has no GL dependency
+class AtlasPacker
+{
+public:
+	AtlasPacker(unsigned width, unsigned height);
+
+	bool insert(unsigned width, unsigned height, glm::uvec2& position);
+	void clear();
+
+	const glm::uvec2& getSize() const;
+
+private:
+	struct Segment
+	{
+		unsigned x;
+		unsigned y;
+		unsigned width;
+	};
+
+	bool fits(std::size_t index, unsigned width, unsigned height, unsigned& y) const;
+
+	glm::uvec2           size;
+	std::vector<Segment> skyline;
+};
+
+// Part of an atlas page occupied by one source image
+struct AtlasRegion
+{
+	std::size_t page = 0;
+	glm::fRect  rect;
+};
+
+// Packs many images into a few large RGBA pages, so sprites from different files share one texture.
+// Regions are in pixels and go straight to Sprite::setTextureRect / AnimationManager::add (as an offset).
+// Every image is surrounded by padding pixels repeating its edges, so the pages can be filtered and mipmapped.
+class TextureAtlas
+{
+public:
+	TextureAtlas(unsigned page_width = 2048, unsigned page_height = 2048, unsigned padding = 1);
+	TextureAtlas(const TextureAtlas&) = delete;
+	TextureAtlas& operator = (const TextureAtlas&) = delete;
+
+	bool addImage(const std::string& name, const std::string& file_path);
+	bool addImage(const std::string& name, const unsigned char* rgba_pixels, unsigned width, unsigned height);
+
+	// Places all added images and composes page pixels on the CPU
+	bool pack();
+	// Creates textures from the packed pages, requires a GL context
+	bool upload();
+
+	// Offline bake: writes <path>_<page>.png images and a text descriptor to <path>.atlas
+	bool saveToFile(const std::string& path) const;
+	// Loads a baked atlas and uploads its pages
+	bool loadFromFile(const std::string& descriptor_path);
+
+	const AtlasRegion* getRegion(const std::string& name) const;
+	glm::fRect         getRect(const std::string& name) const;
+	Texture*           getTexture(std::size_t page) const;
+	Texture*           getTexture(const std::string& name) const;
+	std::size_t        getPageCount() const;
+
+private:
+	struct Image
+	{
+		std::string                name;
+		unsigned                   width;
+		unsigned                   height;
+		std::vector<unsigned char> pixels;
+	};
+
+	glm::uvec2                               page_size;
+	unsigned                                 padding;
+	std::vector<Image>                       images;
+	std::vector<std::vector<unsigned char>>  pages;
+	std::vector<std::unique_ptr<Texture>>    textures;
+	std::map<std::string, AtlasRegion>       regions;
+};
@@ -0,0 +1,201 @@
+#include "TextureCache.hpp"
+
+#include <iostream>
+
+TextureCache::TextureCache(std::size_t memory_budget):
+	owner_thread(std::this_thread::get_id()),
+	memory_budget(memory_budget),
+	memory_usage(0),
+	clock(0)
+{
+}
+
+std::uint64_t TextureCache::hash(std::string_view file_path)
+{
+	// FNV-1a
+	std::uint64_t value = 14695981039346656037ull;
+
+	for (char character : file_path)
+	{
+		value ^= static_cast<unsigned char>(character);
+		value *= 1099511628211ull;
+	}
+	return value;
+}
+
+TextureHandle TextureCache::acquire(std::string_view file_path)
+{
+	const std::uint64_t key = hash(file_path);
+	std::uint32_t index;
+	bool need_load = false;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		if (auto found = lookup.find(key); found != lookup.end() && slots[found->second].path == file_path)
+		{
+			index = found->second;
+		}
+		else
+		{
+			if (found != lookup.end())
+				std::cout << "Texture cache: hash collision for " << file_path << '\n';
+
+			if (!free_slots.empty())
+			{
+				index = free_slots.back();
+				free_slots.pop_back();
+			}
+			else
+			{
+				index = static_cast<std::uint32_t>(slots.size());
+				slots.emplace_back();
+			}
+
+			Slot& slot = slots[index];
+			slot.path = std::string(file_path);
+			slot.key  = key;
+			lookup[key] = index;
+
+			if (std::this_thread::get_id() == owner_thread)
+				need_load = true;
+			else
+				load_queue.push_back(index);
+		}
+
+		Slot& slot = slots[index];
+		slot.ref_count++;
+		slot.last_use = ++clock;
+	}
+
+	if (need_load)
+	{
+		load(index);
+		evict();
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	return { index, slots[index].generation };
+}
+
+void TextureCache::release(TextureHandle handle)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (isAlive(handle) && slots[handle.index].ref_count > 0)
+		slots[handle.index].ref_count--;
+}
+
+Texture* TextureCache::get(TextureHandle handle)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (!isAlive(handle))
+		return nullptr;
+
+	Slot& slot = slots[handle.index];
+	slot.last_use = ++clock;
+
+	return slot.texture.get();
+}
+
+void TextureCache::update()
+{
+	std::vector<std::uint32_t> queue;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queue.swap(load_queue);
+	}
+
+	for (auto index : queue)
+		load(index);
+
+	evict();
+}
+
+void TextureCache::setMemoryBudget(std::size_t bytes)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	memory_budget = bytes;
+}
+
+std::size_t TextureCache::getMemoryBudget() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return memory_budget;
+}
+
+std::size_t TextureCache::getMemoryUsage() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return memory_usage;
+}
+
+std::size_t TextureCache::getTextureMemory(TextureHandle handle) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return isAlive(handle) ? slots[handle.index].memory : 0;
+}
+
+std::size_t TextureCache::getTextureCount() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return lookup.size();
+}
+
+void TextureCache::load(std::uint32_t index)
+{
+	std::string path;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		path = slots[index].path;
+	}
+
+	// Decoding takes long, other threads keep using the cache meanwhile. The texture stays unpublished until loaded
+	auto texture = std::make_unique<Texture>();
+	texture->loadFromFile(path);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	Slot& slot = slots[index];
+	slot.memory   = texture->getMemorySize();
+	slot.texture  = std::move(texture);
+	memory_usage += slot.memory;
+}
+
+void TextureCache::evict()
+{
+	std::vector<std::unique_ptr<Texture>> evicted;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		while (memory_usage > memory_budget)
+		{
+			Slot* victim = nullptr;
+
+			for (auto& slot : slots)
+				if (slot.texture && slot.ref_count == 0 && (!victim || slot.last_use < victim->last_use))
+					victim = &slot;
+
+			if (!victim) break; // Everything left is in use
+
+			std::uint32_t index = static_cast<std::uint32_t>(victim - slots.data());
+
+			memory_usage -= victim->memory;
+			evicted.emplace_back(std::move(victim->texture));
+			if (auto found = lookup.find(victim->key); found != lookup.end() && found->second == index)
+				lookup.erase(found);
+
+			victim->path.clear();
+			victim->memory = 0;
+			if (++victim->generation == 0) victim->generation = 1;
+
+			free_slots.push_back(index);
+		}
+	}
+	// GL objects are deleted here, outside of the lock
+}
+
+bool TextureCache::isAlive(TextureHandle handle) const
+{
+	return handle.isValid() && handle.index < slots.size() && slots[handle.index].generation == handle.generation;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Texture.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Refers to a cache slot. A handle outlives its texture safely: once the slot is reused the generation differs
+struct TextureHandle
+{
+	std::uint32_t index      = 0;
+	std::uint32_t generation = 0; // Zero is never used by a live slot
+
+	bool isValid() const
+	{
+		return generation != 0;
+	}
+};
+
+// Shared textures keyed by the hash of their path. Every acquire() must be paired with release().
+// Unused textures stay resident until the memory budget is exceeded, then the least recently used go first.
+// acquire/release/get may be called from any thread; GL work happens only on the thread that created the cache.
+class TextureCache
+{
+public:
+	TextureCache(std::size_t memory_budget = 512 * 1024 * 1024);
+	TextureCache(const TextureCache&) = delete;
+	TextureCache& operator = (const TextureCache&) = delete;
+
+	static std::uint64_t hash(std::string_view file_path);
+
+	// On the owner thread the texture is loaded at once, otherwise by the next update()
+	TextureHandle acquire(std::string_view file_path);
+	void          release(TextureHandle handle);
+	// Returns nullptr for a stale handle or a texture that is not loaded yet
+	Texture*      get(TextureHandle handle);
+
+	// Owner thread only: loads queued textures and evicts unused ones above the budget
+	void update();
+
+	void        setMemoryBudget(std::size_t bytes);
+	std::size_t getMemoryBudget() const;
+	std::size_t getMemoryUsage() const;
+	std::size_t getTextureMemory(TextureHandle handle) const;
+	std::size_t getTextureCount() const;
+
+private:
+	struct Slot
+	{
+		std::string              path;
+		std::uint64_t            key        = 0;
+		std::uint32_t            generation = 1;
+		std::uint32_t            ref_count  = 0;
+		std::size_t              memory     = 0;
+		std::uint64_t            last_use   = 0;
+		std::unique_ptr<Texture> texture;
+	};
+
+	void load(std::uint32_t index);
+	void evict();
+	bool isAlive(TextureHandle handle) const;
+
+	mutable std::mutex                               mutex;
+	std::thread::id                                  owner_thread;
+	std::vector<Slot>                                slots;
+	std::vector<std::uint32_t>                       free_slots;
+	std::vector<std::uint32_t>                       load_queue;
+	std::unordered_map<std::uint64_t, std::uint32_t> lookup;
+	std::size_t                                      memory_budget;
+	std::size_t                                      memory_usage;
+	std::uint64_t                                    clock;
+};
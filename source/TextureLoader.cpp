@@ -0,0 +1,195 @@
+#include "TextureLoader.hpp"
+#include "GLState.hpp"
+#include "Profiler.hpp"
+
+#include "stb_image.h"
+
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+
+TextureLoader::TextureLoader(unsigned thread_count, std::size_t bytes_per_frame):
+	bytes_per_frame(std::max<std::size_t>(bytes_per_frame, 1)),
+	is_running(true),
+	pixel_buffers(),
+	pixel_buffer_index(0)
+{
+	glGenBuffers(2, pixel_buffers);
+
+	for (unsigned i = 0; i < std::max(thread_count, 1u); ++i)
+		workers.emplace_back(&TextureLoader::decode, this);
+}
+
+TextureLoader::~TextureLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(jobs_mutex);
+		is_running = false;
+	}
+	jobs_condition.notify_all();
+
+	for (auto& worker : workers)
+		worker.join();
+
+	glDeleteBuffers(2, pixel_buffers);
+	GLState::onBuffersDeleted(2, pixel_buffers);
+}
+
+Texture* TextureLoader::load(const std::string& file_path, const TileLayout& layout)
+{
+	if (auto found = textures.find(file_path); found != textures.end())
+		return found->second.get();
+
+	// Only the header is read here, the size must be known before the pixels
+	int width, height, channels;
+
+	if (!stbi_info(file_path.c_str(), &width, &height, &channels))
+	{
+		std::cout << "Failed to load texture " + file_path + '\n';
+		return nullptr;
+	}
+
+	channels = channels == 3 ? 3 : 4;
+
+	if (layout.border > 0)
+		GetExtrudedSize(width, height, layout, width, height);
+
+	auto texture = std::make_unique<Texture>();
+
+	if (layout.border > 0)
+		texture->setLevelLimit(GetProtectedLevelCount(layout));
+
+	if (!texture->create(width, height, channels))
+		return nullptr;
+
+	Texture* handle = texture.get();
+	textures.emplace(file_path, std::move(texture));
+	pending.push_back(handle);
+
+	{
+		std::lock_guard<std::mutex> lock(jobs_mutex);
+		jobs.push_back({ file_path, handle, channels, layout });
+	}
+	jobs_condition.notify_one();
+
+	return handle;
+}
+
+void TextureLoader::update()
+{
+	PROFILE_SCOPE("TextureLoader::update");
+
+	{
+		std::lock_guard<std::mutex> lock(decoded_mutex);
+
+		while (!decoded.empty())
+		{
+			uploads.emplace_back(std::move(decoded.front()));
+			decoded.pop_front();
+		}
+	}
+
+	std::size_t budget = bytes_per_frame;
+
+	while (budget > 0 && !uploads.empty())
+	{
+		Upload& upload = uploads.front();
+		const DecodedImage& image = upload.image;
+
+		if (!image.getPixels()) // Decoding failed, the placeholder stays
+		{
+			pending.erase(std::remove(pending.begin(), pending.end(), upload.texture), pending.end());
+			uploads.pop_front();
+			continue;
+		}
+
+		const std::size_t row_size = std::size_t(image.getWidth()) * image.getChannels();
+		const int         rows     = static_cast<int>(std::min<std::size_t>(image.getHeight() - upload.next_row, std::max<std::size_t>(budget / row_size, 1)));
+		const std::size_t bytes    = rows * row_size;
+
+		// Two buffers in turn, so a new chunk doesn't wait for the previous transfer
+		GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, pixel_buffers[pixel_buffer_index]);
+		pixel_buffer_index ^= 1;
+
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+
+		if (void* destination = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT))
+		{
+			std::memcpy(destination, image.getPixels() + upload.next_row * row_size, bytes);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+			upload.texture->update(nullptr, 0, upload.next_row, image.getWidth(), rows);
+		}
+		else // Mapping failed, upload straight from memory
+		{
+			GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			upload.texture->update(image.getPixels() + upload.next_row * row_size, 0, upload.next_row, image.getWidth(), rows);
+		}
+
+		// Unlike other bindings this one changes the meaning of every later pixel upload
+		GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		GLState::onUpload(bytes);
+
+		upload.next_row += rows;
+		budget -= std::min(budget, bytes);
+
+		if (upload.next_row == image.getHeight())
+		{
+			upload.texture->generateMipmap();
+			pending.erase(std::remove(pending.begin(), pending.end(), upload.texture), pending.end());
+			uploads.pop_front();
+		}
+	}
+}
+
+bool TextureLoader::isLoaded(const Texture* texture) const
+{
+	return std::find(pending.begin(), pending.end(), texture) == pending.end();
+}
+
+std::size_t TextureLoader::getPendingCount() const
+{
+	return pending.size();
+}
+
+void TextureLoader::decode()
+{
+	Profiler::setThreadName("Texture decoder");
+
+	while (true)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(jobs_mutex);
+			jobs_condition.wait(lock, [this] { return !jobs.empty() || !is_running; });
+
+			if (!is_running)
+				return;
+
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+
+		PROFILE_SCOPE("TextureLoader::decode");
+
+		Upload upload;
+		upload.texture = job.texture;
+
+		if (!Texture::decodeImage(job.file_path, upload.image, job.channels))
+			std::cout << "Failed to decode texture " + job.file_path + '\n';
+		else if (job.layout.border > 0)
+		{
+			const DecodedImage& image = upload.image;
+			const int channels = image.getChannels();
+			int width, height;
+
+			GetExtrudedSize(image.getWidth(), image.getHeight(), job.layout, width, height);
+			std::vector<unsigned char> extruded = ExtrudeTiles(image.getPixels(), image.getWidth(), image.getHeight(), channels, job.layout);
+
+			upload.image.assign(std::move(extruded), width, height, channels);
+		}
+
+		std::lock_guard<std::mutex> lock(decoded_mutex);
+		decoded.emplace_back(std::move(upload));
+	}
+}
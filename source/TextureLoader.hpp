@@ -0,0 +1,71 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "Texture.hpp"
+#include "ImageCache.hpp"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+// Loads textures in the background. Images are decoded by a pool of worker threads,
+// the render thread uploads them through pixel buffers in bounded chunks per frame.
+// A texture returned by load() is usable at once: it has the final size and stays transparent until uploaded.
+class TextureLoader
+{
+public:
+	TextureLoader(unsigned thread_count = 2, std::size_t bytes_per_frame = 4 * 1024 * 1024);
+	TextureLoader(const TextureLoader&) = delete;
+	TextureLoader& operator = (const TextureLoader&) = delete;
+	~TextureLoader();
+
+	// Must be called from the GL thread. Returns nullptr if the file is not a readable image.
+	// A tile layout with a border extrudes the tiles on the worker (see ExtrudeTiles), textures are shared by path
+	Texture* load(const std::string& file_path, const TileLayout& layout = {});
+	// Uploads decoded images within the per frame budget. Call once per frame from the GL thread
+	void update();
+
+	bool        isLoaded(const Texture* texture) const;
+	std::size_t getPendingCount() const;
+
+private:
+	struct Job
+	{
+		std::string file_path;
+		Texture*    texture;
+		int         channels;
+		TileLayout  layout;
+	};
+
+	struct Upload
+	{
+		Texture*     texture  = nullptr;
+		int          next_row = 0;
+		DecodedImage image;
+	};
+
+	void decode();
+
+	std::size_t                                     bytes_per_frame;
+	std::map<std::string, std::unique_ptr<Texture>> textures;
+	std::vector<const Texture*>                     pending;
+
+	std::deque<Job>          jobs;
+	std::deque<Upload>       decoded;
+	std::deque<Upload>       uploads;
+	std::mutex               jobs_mutex;
+	std::mutex               decoded_mutex;
+	std::condition_variable  jobs_condition;
+	std::atomic<bool>        is_running;
+	std::vector<std::thread> workers;
+
+	GLuint      pixel_buffers[2];
+	std::size_t pixel_buffer_index;
+};
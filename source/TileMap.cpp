@@ -1,4 +1,6 @@
 #include "TileMap.hpp"
+#include "GLState.hpp"
+#include "Profiler.hpp"
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -10,8 +12,10 @@
 #include <iostream>
 #include <algorithm>
 
+static constexpr UniformName MODEL_UNIFORM("model");
+
 TileMap::TileMap(glm::ivec2* scr_size):
-	tileset(nullptr), position(), bounds(), screen_size(scr_size), viewport_need_update(true)
+	tileset(nullptr), position(), bounds(), screen_size(scr_size)
 {	
 }
 
@@ -19,13 +23,40 @@ TileMap::~TileMap()
 {
 	for (auto& layer : layers)
 	{
-		glDeleteBuffers(1, &layer.VBO);
+		GLuint buffers[] { layer.VBO, layer.EBO };
+
+		glDeleteBuffers(2, buffers);
 		glDeleteVertexArrays(1, &layer.VAO);
+
+		GLState::onBuffersDeleted(2, buffers);
+		GLState::onVertexArrayDeleted(layer.VAO);
 	}	
 }
 
-bool TileMap::load(const char* tmx_file_path, Texture* texture)
+TileLayout TileMap::readTileLayout(const char* tmx_file_path, int border)
 {
+	TileLayout layout;
+	tinyxml2::XMLDocument document;
+
+	if (document.LoadFile(tmx_file_path) != tinyxml2::XML_SUCCESS || !document.FirstChildElement("map"))
+	{
+		std::cout << "Loading file " << tmx_file_path << " failed...\n";
+		return layout;
+	}
+
+	const tinyxml2::XMLElement* root_element = document.FirstChildElement("map");
+
+	layout.tile_width  = root_element->IntAttribute("tilewidth");
+	layout.tile_height = root_element->IntAttribute("tileheight");
+	layout.border      = border;
+
+	return layout;
+}
+
+bool TileMap::load(const char* tmx_file_path, Texture* texture, int tile_border)
+{
+	PROFILE_SCOPE("TileMap::load");
+
 	tileset = texture;
 
 	tinyxml2::XMLDocument document;
@@ -45,8 +76,12 @@ bool TileMap::load(const char* tmx_file_path, Texture* texture)
 	const GLuint tile_width   = std::atoi(root_element->Attribute("tilewidth"));
 	const GLuint tile_height  = std::atoi(root_element->Attribute("tileheight"));
 
-	const GLuint row_count    = tileset->getSize().y / tile_height;
-	const GLuint column_count = tileset->getSize().x / tile_width;
+	// Extruded tiles sit inside bigger cells, so UVs stay off the neighbouring tiles under any filtering
+	const GLuint cell_width   = tile_width  + 2 * tile_border;
+	const GLuint cell_height  = tile_height + 2 * tile_border;
+
+	const GLuint row_count    = tileset->getSize().y / cell_height;
+	const GLuint column_count = tileset->getSize().x / cell_width;
 	
 	const glm::uvec2 tex_size   = tileset->getSize();
 
@@ -57,7 +92,7 @@ bool TileMap::load(const char* tmx_file_path, Texture* texture)
 
 	for (unsigned y = 0u; y < row_count; ++y)
 		for (unsigned x = 0u; x < column_count; ++x)
-			texture_grid.emplace_back(glm::vec2(x * tile_width, y * tile_height));
+			texture_grid.emplace_back(glm::vec2(x * cell_width + tile_border, y * cell_height + tile_border));
 
 	// Tiles
 	for (auto layer = root_element->FirstChildElement("layer");
@@ -130,13 +165,41 @@ bool TileMap::load(const char* tmx_file_path, Texture* texture)
 
 		GLuint VAO = 0, VBO = 0, EBO = 0;
 
+		if (GLState::hasDirectStateAccess())
+		{
+			glCreateVertexArrays(1, &VAO);
+			glCreateBuffers(1, &VBO);
+			glCreateBuffers(1, &EBO);
+
+			// Immutable storage can't be empty, a layer without tiles just keeps the names
+			if (!indices.empty())
+			{
+				glNamedBufferStorage(VBO, sizeof(glm::vec4) * vertices.size(), vertices.data(), 0);
+				glNamedBufferStorage(EBO, sizeof(GLuint) * indices.size(), indices.data(), 0);
+			}
+
+			glVertexArrayVertexBuffer(VAO, 0, VBO, 0, sizeof(glm::vec4));
+			glVertexArrayElementBuffer(VAO, EBO);
+
+			glVertexArrayAttribFormat(VAO, 0, 2, GL_FLOAT, GL_FALSE, 0);
+			glVertexArrayAttribBinding(VAO, 0, 0);
+			glEnableVertexArrayAttrib(VAO, 0);
+
+			glVertexArrayAttribFormat(VAO, 1, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float));
+			glVertexArrayAttribBinding(VAO, 1, 0);
+			glEnableVertexArrayAttrib(VAO, 1);
+
+			layers.push_back({ VAO, VBO, EBO, static_cast<GLuint>(indices.size()) });
+			continue;
+		}
+
 		glGenVertexArrays(1, &VAO);
 		glGenBuffers(1, &VBO);
 		glGenBuffers(1, &EBO);
 
-		glBindVertexArray(VAO);
+		GLState::bindVertexArray(VAO);
 
-		glBindBuffer(GL_ARRAY_BUFFER, VBO);
+		GLState::bindBuffer(GL_ARRAY_BUFFER, VBO);
 		glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec4) * vertices.size(), vertices.data(), GL_STATIC_DRAW);
 
 		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), NULL);
@@ -145,11 +208,14 @@ bool TileMap::load(const char* tmx_file_path, Texture* texture)
 		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
 		glEnableVertexAttribArray(1);
 
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+		GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
 		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint)* indices.size(), indices.data(), GL_STATIC_DRAW);
 
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindVertexArray(0);		
+		if (GLState::unbind_after_use)
+		{
+			GLState::bindBuffer(GL_ARRAY_BUFFER, 0);
+			GLState::bindVertexArray(0);
+		}
 
 		layers.push_back({ VAO, VBO, EBO, static_cast<GLuint>(indices.size()) });
 	}
@@ -221,33 +287,54 @@ void TileMap::setViewport(const glm::vec2& center)
 	float ratioY = bounds.y / screen_size->y;
 	// Shift the map relatively window
 	position = { -center.x * ratioX + screen_size->x, -center.y * ratioY + screen_size->y * 0.5f };
-
-	viewport_need_update = true;	
 }
 
 void TileMap::render(ShaderProgram* shader)
 {
+	PROFILE_SCOPE("TileMap::render");
+
 	tileset->bind(true);
 	
 	shader->use();
 
-	if (viewport_need_update)
+	draw(shader);
+			
+	tileset->bind(false);	
+}
+
+void TileMap::submit(RenderQueue& queue, ShaderProgram* shader, std::uint8_t layer)
+{
+	RenderCommand command;
+	command.key     = RenderQueue::makeKey(layer, shader->getNativeHandle(), tileset->getNativeHandle(), 0);
+	command.shader  = shader;
+	command.texture = tileset;
+	command.object  = this;
+	command.draw    = [](void* object, ShaderProgram* program)
 	{
-		glm::mat4 viewport_matrix(1.0f);
-		viewport_matrix = glm::translate(viewport_matrix, glm::vec3(position, 0.0f));
-		shader->setUniform("view", glm::value_ptr(viewport_matrix));
+		static_cast<TileMap*>(object)->draw(program);
+	};
+	queue.submit(command);
+}
 
-		viewport_need_update = false;
-	}
+void TileMap::draw(ShaderProgram* shader)
+{
+	PROFILE_SCOPE("TileMap::draw");
+	PROFILE_GPU_SCOPE("TileMap");
+
+	// Every draw, as Sprite does: the program may be new since the last one (hot reload, another shader)
+	glm::mat4 viewport_matrix(1.0f);
+	viewport_matrix = glm::translate(viewport_matrix, glm::vec3(position, 0.0f));
+	shader->setUniform(MODEL_UNIFORM, viewport_matrix);
 
 	for (auto& layer : layers)
 	{
-		glBindVertexArray(layer.VAO);
+		GLState::bindVertexArray(layer.VAO);
 		glDrawElements(GL_TRIANGLES, layer.size, GL_UNSIGNED_INT, nullptr);
-		glBindVertexArray(0);
+		GLState::onDraw(layer.size / 3);
 	}
-			
-	tileset->bind(false);	
+
+	if (GLState::unbind_after_use)
+		GLState::bindVertexArray(0);
 }
 
 Object* TileMap::getObject(const std::string& name)
@@ -257,7 +344,7 @@ Object* TileMap::getObject(const std::string& name)
 			return obj.name == name;
 		}); 
 		object != objects.end()) 
-			return object._Ptr;
+			return &*object;
 
 	return nullptr;
 }
@@ -7,6 +7,9 @@
 #include "Texture.hpp"
 #include "Rectangle.hpp"
 #include "ShaderProgram.hpp"
+#include "RenderQueue.hpp"
+
+#include <cstdint>
 
 #include <string>
 #include <vector>
@@ -42,9 +45,17 @@ public:
 	TileMap& operator = (const TileMap&) = delete;
 	~TileMap();
 
-	bool load(const char* tmx_file_path, Texture* texture);
+	// Tile size the map is made of with the given border, for extruding its tileset before the map is loaded.
+	// The tile size is zero when the file can't be read
+	static TileLayout readTileLayout(const char* tmx_file_path, int border);
+
+	// tile_border is the extrusion of the tileset (see TileLayout), zero for a plain grid
+	bool load(const char* tmx_file_path, Texture* texture, int tile_border = 0);
 	void setViewport(const glm::vec2& center);
 	void render(ShaderProgram* shader);
+	void submit(RenderQueue& queue, ShaderProgram* shader, std::uint8_t layer);
+	// Issues the draw calls only, the shader and the tileset must be bound already
+	void draw(ShaderProgram* shader);
 
 	Object*              getObject(const std::string& name);
 	std::vector<Object>  getObjectsByName(const std::string& name);
@@ -58,5 +69,4 @@ private:
 	glm::vec2           position;
 	glm::vec2           bounds;
 	glm::ivec2*         screen_size;
-	bool                viewport_need_update;
 };
\ No newline at end of file
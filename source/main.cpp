@@ -5,155 +5,313 @@
 #include "Sprite.hpp"
 #include "Animation.hpp"
 #include "TileMap.hpp"
+#include "RenderQueue.hpp"
+#include "GLState.hpp"
+#include "TextureLoader.hpp"
+#include "ImageCache.hpp"
+#include "Camera.hpp"
+#include "ShaderWatcher.hpp"
+#include "ShaderPermutations.hpp"
+#include "GameLoop.hpp"
+#include "Profiler.hpp"
+#include "RenderStats.hpp"
+#include "GraphicsContext.hpp"
+#include "RenderTarget.hpp"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
 #include <iostream>
-#include <Windows.h>
+#include <string>
+#include <thread>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 bool IsKeyPressed(GLFWwindow* window, const int key);
 
 glm::ivec2 screen_size = glm::ivec2(1200, 800);
 
-int main()
+// 2DEngene [--headless egl|osmesa|null] [--frames N] [--dump directory] [--dump-every N]
+// Headless runs draw N frames (300 by default) offscreen on a fixed 60 Hz clock, so their images are reproducible
+int main(int argc, char* argv[])
 {
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    ContextBackend backend     = ContextBackend::Window;
+    unsigned       frame_limit = 0;
+    std::string    dump_directory;
+    unsigned       dump_every  = 1;
 
-    GLFWwindow* window = glfwCreateWindow(screen_size.x, screen_size.y, "OpenGL Entities", NULL, NULL);
-
-    if (window == NULL)
+    for (int i = 1; i < argc; ++i)
     {
-        std::cout << "Failed to create GLFW window\n";
-        glfwTerminate();
-        return -1;
+        const std::string option = argv[i];
+        const char*       value  = i + 1 < argc ? argv[i + 1] : "";
+
+        if (option == "--headless" && GraphicsContext::parseBackend(value, backend))
+            ++i;
+        else if (option == "--frames" && *value)
+            frame_limit = std::strtoul(argv[++i], nullptr, 10);
+        else if (option == "--dump" && *value)
+            dump_directory = argv[++i];
+        else if (option == "--dump-every" && *value)
+            dump_every = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+        else
+        {
+            std::cout << "Unknown option " << option << '\n';
+            return -1;
+        }
     }
-    glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
-    {
-        std::cout << "Failed to initialize GLAD" << std::endl;
+    // Declared first, so it outlives every GL object below
+    GraphicsContext graphics;
+
+    if (!graphics.create(backend, screen_size, "OpenGL Entities"))
         return -1;
+
+    GLFWwindow* window = graphics.getWindow();
+
+    if (window)
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+    // Headless contexts have no default framebuffer
+    RenderTarget render_target;
+
+    if (graphics.isHeadless())
+    {
+        if (!render_target.create(screen_size))
+            return -1;
+
+        if (frame_limit == 0)
+            frame_limit = 300;
     }
 
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    // ENGINE_TRACE=file.json records a Chrome trace of the run
+    const char* trace_path = std::getenv("ENGINE_TRACE");
+    Profiler::setEnabled(trace_path != nullptr);
+    Profiler::setThreadName("Main");
+
+    // Premultiplied alpha filters without dark fringes and lets additive sprites share the batch
+    Texture::setPremultipliedAlpha(true);
 
-    Texture* tileset = GetTexture("res/textures/main_tileset.png");
+    GLState::setBlending(true);
+
+    if (Texture::isPremultipliedAlpha())
+        GLState::setBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    else
+        GLState::setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    // Decoded images are kept on disk, so the next run skips PNG decoding
+    ImageCache image_cache;
+    Texture::setImageCache(&image_cache);
+
+    // The tileset is large, so it's decoded in the background while the first frames run
+    TextureLoader texture_loader;
+
+    // Tiles are extruded, so the tileset can be drawn smooth and zoomed without seams between them.
+    // The tile size comes from the map, the tileset is cut the way the map uses it
+    const char*      level_path     = "res/levels/Map_1.tmx";
+    const TileLayout tileset_layout = TileMap::readTileLayout(level_path, 2);
+
+    Texture* tileset = texture_loader.load("res/textures/main_tileset.png", tileset_layout);
     Texture* characters = GetTexture("res/textures/Characters_1.png");
 
+    if (!tileset || !characters)
+        return -1;
+
     TileMap level(&screen_size);
-    level.load("res/levels/Map_1.tmx", tileset);
+    level.load(level_path, tileset, tileset_layout.border);
+
+    // Projection, view and time are shared by all programs through one uniform buffer
+    Camera camera;
+
+    // Linked programs are kept on disk too, the next run loads them without compiling
+    ProgramCache program_cache;
+    ShaderProgram::setProgramCache(&program_cache);
 
-    glm::mat4 projection(1.0f);
-    projection = glm::ortho(0.0f, (float)screen_size.x, (float)screen_size.y, 0.0f, 0.0f, 1.0f);
-    
     ShaderProgram tilemap_shader;
     tilemap_shader.compile("res/shaders/tilemap_shader.vert", GL_VERTEX_SHADER);
     tilemap_shader.compile("res/shaders/tilemap_shader.frag", GL_FRAGMENT_SHADER);
-    tilemap_shader.addUniform("view");
-    tilemap_shader.addUniform("projection");
-
-    tilemap_shader.use();
-    tilemap_shader.setUniform("projection", glm::value_ptr(projection));
+    tilemap_shader.link();
 
-    ShaderProgram sprite_shader;
-    sprite_shader.compile("res/shaders/sprite_shader.vert", GL_VERTEX_SHADER);
-    sprite_shader.compile("res/shaders/sprite_shader.frag", GL_FRAGMENT_SHADER);
-    sprite_shader.addUniform("model");
-    sprite_shader.addUniform("projection");
+    // Edited shader files are picked up while the game runs
+    ShaderWatcher shader_watcher;
+    shader_watcher.watch(&tilemap_shader);
 
-    sprite_shader.use();
-    sprite_shader.setUniform("projection", glm::value_ptr(projection));
+    // Every sprite draws with the variant that has only the features it uses
+    ShaderPermutations sprite_shaders("res/shaders/sprite_shader.vert", "res/shaders/sprite_shader.frag", Sprite::SHADER_FEATURES);
+    sprite_shaders.setWatcher(&shader_watcher);
+    sprite_shaders.preload({ 0, SPRITE_TINT });
 
     AnimationManager sprite;
     sprite.setTexture(characters);
-    sprite.add("walk down",  0, 192, 32, 48, 3, 0.5f);
-    sprite.add("walk left",  0, 240, 32, 48, 3, 0.5f);
-    sprite.add("walk right", 0, 288, 32, 48, 3, 0.5f);
-    sprite.add("walk up",    0, 336, 32, 48, 3, 0.5f);
-    sprite.set("walk left");
+    // Names are resolved here once, the loop switches clips by id
+    const ClipId walk_down  = sprite.add("walk down",  0, 192, 32, 48, 3, 0.1f);
+    const ClipId walk_left  = sprite.add("walk left",  0, 240, 32, 48, 3, 0.1f);
+    const ClipId walk_right = sprite.add("walk right", 0, 288, 32, 48, 3, 0.1f);
+    const ClipId walk_up    = sprite.add("walk up",    0, 336, 32, 48, 3, 0.1f);
+    sprite.set(walk_left);
     sprite.play();
     sprite.setPosition(1180, 520);
+    // Placing isn't movement, there is nothing to interpolate from
+    sprite.savePreviousState();
+
+    RenderQueue render_queue;
+
+    // ENGINE_STATS=file.csv writes a row of render statistics per frame, once a second at 60 fps
+    RenderStats render_stats;
+
+    if (const char* stats_path = std::getenv("ENGINE_STATS"))
+        render_stats.setCsvOutput(stats_path, 60);
+
+    // Gameplay runs at 60 steps per second, frames in between draw the sprite interpolated
+    GameLoop game_loop;
+    const float walk_speed = 120.0f; // Pixels per second
+
+    if (graphics.isHeadless())
+    {
+        // Every image of a headless run has to be the same, so nothing may still be loading
+        while (texture_loader.getPendingCount() > 0)
+        {
+            texture_loader.update();
+            std::this_thread::yield();
+        }
+
+        render_target.bind();
+    }
+
+    const auto start_time = std::chrono::steady_clock::now();
 
     float fps = 0;
     float time = 0, last_time = 0;
     float frame_time = 0;
+    float wall_time = 0;
     unsigned counter = 0;
 
-    while (!glfwWindowShouldClose(window))
+    while ((!window || !glfwWindowShouldClose(window)) && (frame_limit == 0 || counter < frame_limit))
     {
-        time = static_cast<float>(glfwGetTime());
+        wall_time = std::chrono::duration<float>(std::chrono::steady_clock::now() - start_time).count();
+
+        // Headless runs step a fixed clock, the frames don't depend on how fast the machine is
+        time = graphics.isHeadless() ? counter / 60.0f : wall_time;
         frame_time = time - last_time;
         last_time = time;
         counter++;
 
+        PROFILE_SCOPE("Frame");
+
         if(IsKeyPressed(window, GLFW_KEY_ESCAPE))
             glfwSetWindowShouldClose(window, true);
 
-        sprite.pause();
+        game_loop.beginFrame(frame_time);
 
-        if (IsKeyPressed(window, GLFW_KEY_A))
+        while (game_loop.step())
         {
-            sprite.move(-2.0f, 0.0f);
-            sprite.set("walk left");
-            sprite.play();
+            PROFILE_SCOPE("Simulation step");
+
+            const float step_time = game_loop.getStepTime();
+            const float distance  = walk_speed * step_time;
+
+            sprite.savePreviousState();
+            sprite.pause();
+
+            if (IsKeyPressed(window, GLFW_KEY_A))
+            {
+                sprite.move(-distance, 0.0f);
+                sprite.set(walk_left);
+                sprite.play();
+            }
+
+            if (IsKeyPressed(window, GLFW_KEY_D))
+            {
+                sprite.move(distance, 0.0f);
+                sprite.set(walk_right);
+                sprite.play();
+            }
+
+            if (IsKeyPressed(window, GLFW_KEY_W))
+            {
+                sprite.move(0.0f, -distance);
+                sprite.set(walk_up);
+                sprite.play();
+            }
+
+            if (IsKeyPressed(window, GLFW_KEY_S))
+            {
+                sprite.move(0.0f, distance);
+                sprite.set(walk_down);
+                sprite.play();
+            }
+
+            sprite.tick(step_time);
         }
 
-        if (IsKeyPressed(window, GLFW_KEY_D))
-        {
-            sprite.move(2.0f, 0.0f);
-            sprite.set("walk right");
-            sprite.play();
-        }
+        sprite.setInterpolation(game_loop.getInterpolation());
+        level.setViewport(sprite.getInterpolatedPosition());
+
+        texture_loader.update();
+        shader_watcher.update();
 
-        if (IsKeyPressed(window, GLFW_KEY_W))
+        // Follows window resizes, the projection is rebuilt only when the size changes
+        camera.setViewport(screen_size);
+        camera.setTime(time);
+        camera.update();
+
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        level.submit(render_queue, &tilemap_shader, 0);
+        sprite.submit(render_queue, sprite_shaders, 1);
+
+        render_queue.execute();
+        render_queue.clear();
+
+        if (graphics.isHeadless() && !dump_directory.empty() && counter % dump_every == 0)
         {
-            sprite.move(0.0f, -2.0f);
-            sprite.set("walk up");
-            sprite.play();
+            char file_name[32];
+            std::snprintf(file_name, sizeof(file_name), "/frame_%05u.png", counter);
+            render_target.saveToPng(dump_directory + file_name);
         }
 
-        if (IsKeyPressed(window, GLFW_KEY_S))
         {
-            sprite.move(0.0f, 2.0f);          
-            sprite.set("walk down");
-            sprite.play();
+            PROFILE_SCOPE("Swap buffers");
+            graphics.swapBuffers();
         }
 
-        sprite.tick(frame_time * 5);
-        level.setViewport(sprite.getPosition());
+        if (window)
+            glfwPollEvents();
 
-        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
-
-        level.render(&tilemap_shader);
-        sprite.render(&sprite_shader);
-
-        glfwSwapBuffers(window);
-        glfwPollEvents();      
+        Profiler::endFrame();
+        render_stats.endFrame(std::chrono::duration<float>(std::chrono::steady_clock::now() - start_time).count() - wall_time);
     }
 
-    fps = counter / time;
+    if (trace_path)
+        Profiler::writeChromeTrace(trace_path);
+
+    fps = counter / wall_time;
 
     std::cout << "sprite " << sizeof(Sprite)
     << "\nfps " << fps 
     << "\ncounter " << counter 
     << "\ntime " << time
-    << "\nframe time: " << frame_time;
+    << "\nframe time: " << frame_time
+    << "\ngl calls issued: " << GLState::getCounters().issued
+    << "\ngl calls skipped: " << GLState::getCounters().skipped;
+
+    const RenderStats::Summary frame_times = render_stats.getFrameTimeSummary();
+    const FrameStats&          last_frame  = render_stats.getLast();
+
+    std::cout << "\nframe time ms min/avg/max: " << frame_times.min * 1000.0f << " / " << frame_times.average * 1000.0f << " / " << frame_times.max * 1000.0f
+    << "\nframe time ms p50/p95/p99: " << frame_times.p50 * 1000.0f << " / " << frame_times.p95 * 1000.0f << " / " << frame_times.p99 * 1000.0f
+    << "\nlast frame draw calls: " << last_frame.draw_calls
+    << "\nlast frame triangles: " << last_frame.triangles << '\n';
 
-    glfwTerminate();
     return 0;
 }
 
 bool IsKeyPressed(GLFWwindow* window, const int key)
 {
-    return (glfwGetKey(window, key) == GLFW_PRESS) ? true : false;
+    return (window && glfwGetKey(window, key) == GLFW_PRESS) ? true : false;
 }
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
@@ -0,0 +1,89 @@
+#include "Animation.hpp"
+#include "NullGL.hpp"
+
+#include <iostream>
+#include <string>
+
+// Clip naming of AnimationManager, run by ctest. GL is stubbed out (NullGL), so no context or display is needed
+namespace
+{
+	int failures = 0;
+
+	void Check(bool condition, const std::string& what)
+	{
+		if (!condition)
+		{
+			std::cout << "FAILED: " << what << '\n';
+			failures++;
+		}
+	}
+
+	// Two characters of one library, each with its own "walk left" row
+	void TestNamesPerManager(Texture& texture)
+	{
+		AnimationLibrary library;
+
+		AnimationManager first(library);
+		first.setTexture(&texture);
+		const ClipId first_walk = first.add("walk left", 0, 240, 32, 48, 3, 0.1f);
+		const ClipId first_idle = first.add("idle", 0, 0, 32, 48, 1, 0.1f);
+
+		AnimationManager second(library);
+		second.setTexture(&texture);
+		const ClipId second_walk = second.add("walk left", 96, 240, 32, 48, 3, 0.1f);
+
+		Check(first_walk != INVALID_CLIP && second_walk != INVALID_CLIP, "a name reused by another manager is accepted");
+		Check(first_walk != second_walk, "other frames under the same name make another clip");
+		Check(second.getClip() == second_walk, "add switches to the new clip");
+
+		first.set("walk left");
+		Check(first.getClip() == first_walk, "set by name finds the manager's own clip");
+		Check(library.get(first.getClip()).frames[0].left == 0, "first manager plays its own frames");
+		Check(library.get(second.getClip()).frames[0].left == 96, "second manager plays its own frames");
+
+		second.set("idle");
+		Check(second.getClip() == second_walk, "names of another manager are unknown");
+		Check(first_idle != INVALID_CLIP, "idle is defined");
+	}
+
+	// The same strip under any name is stored once
+	void TestSharedFrames(Texture& texture)
+	{
+		AnimationLibrary library;
+
+		AnimationManager first(library);
+		first.setTexture(&texture);
+		const ClipId first_walk = first.add("walk down", 0, 192, 32, 48, 3, 0.1f);
+
+		AnimationManager second(library);
+		second.setTexture(&texture);
+		const ClipId second_walk = second.add("down", 0, 192, 32, 48, 3, 0.1f);
+
+		Check(first_walk == second_walk, "identical strips share one clip");
+		Check(library.size() == 1, "identical strips are stored once");
+	}
+}
+
+int main()
+{
+	if (!NullGL::load())
+	{
+		std::cout << "Failed to load NullGL\n";
+		return 1;
+	}
+
+	Texture texture;
+	texture.create(128, 384, 4);
+
+	TestNamesPerManager(texture);
+	TestSharedFrames(texture);
+
+	if (failures)
+	{
+		std::cout << failures << " checks failed\n";
+		return 1;
+	}
+
+	std::cout << "All checks passed\n";
+	return 0;
+}
@@ -0,0 +1,357 @@
+#include "BlockCompression.hpp"
+#include "Ktx2.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// CPU-only checks of the block codecs and the KTX2 container, run by ctest
+namespace
+{
+	int failures = 0;
+
+	void Check(bool condition, const std::string& what)
+	{
+		if (!condition)
+		{
+			std::cout << "FAILED: " << what << '\n';
+			failures++;
+		}
+	}
+
+	// Fixed LCG, every run encodes the same blocks
+	std::uint32_t seed = 1;
+
+	unsigned Random(unsigned range)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		return (seed >> 8) % range;
+	}
+
+	std::uint32_t ReadU32(const std::vector<unsigned char>& bytes, std::size_t position)
+	{
+		return bytes[position] | (bytes[position + 1] << 8) | (bytes[position + 2] << 16) | (std::uint32_t(bytes[position + 3]) << 24);
+	}
+
+	std::vector<unsigned char> ReadFile(const std::string& path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		return std::vector<unsigned char>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	}
+
+	struct BlockError
+	{
+		double total = 0.0; // Squared error over all blocks
+		int    max   = 0;   // Largest error of a single channel
+	};
+
+	// Encodes and decodes every block, channel_count 3 leaves alpha out of the error
+	template <typename Generator>
+	BlockError RoundTrip(BlockFormat format, int block_count, int channel_count, Generator&& generate)
+	{
+		BlockError error;
+
+		for (int b = 0; b < block_count; ++b)
+		{
+			unsigned char block[64], encoded[16], decoded[64];
+			generate(block);
+
+			if (format == BlockFormat::BC1)
+			{
+				EncodeBC1Block(block, encoded);
+				DecodeBC1Block(encoded, decoded);
+			}
+			else
+			{
+				EncodeBC7Block(block, encoded);
+				Check(DecodeBC7Block(encoded, decoded), "BC7 block decodes");
+			}
+
+			for (int i = 0; i < 16; ++i)
+				for (int c = 0; c < channel_count; ++c)
+				{
+					const int difference = decoded[i * 4 + c] - block[i * 4 + c];
+					error.total += difference * difference;
+					error.max    = std::max(error.max, std::abs(difference));
+				}
+		}
+		return error;
+	}
+
+	void SolidBlock(unsigned char* block, bool opaque)
+	{
+		const unsigned char color[4] { (unsigned char)Random(256), (unsigned char)Random(256), (unsigned char)Random(256),
+		                               (unsigned char)(opaque ? 255 : Random(256)) };
+
+		for (int i = 0; i < 16; ++i)
+			std::copy(color, color + 4, block + i * 4);
+	}
+
+	// Two random colors blended across the block, the common case in real textures
+	void GradientBlock(unsigned char* block, bool opaque)
+	{
+		unsigned char from[4], to[4];
+
+		for (int c = 0; c < 4; ++c)
+		{
+			from[c] = (unsigned char)Random(256);
+			to[c]   = (unsigned char)Random(256);
+		}
+
+		for (int i = 0; i < 16; ++i)
+			for (int c = 0; c < 4; ++c)
+				block[i * 4 + c] = (unsigned char)((c == 3 && opaque) ? 255 : (from[c] * (15 - i) + to[c] * i + 7) / 15);
+	}
+
+	void NoiseBlock(unsigned char* block, bool opaque)
+	{
+		for (int i = 0; i < 64; ++i)
+			block[i] = (unsigned char)((i % 4 == 3 && opaque) ? 255 : Random(256));
+	}
+
+	void WriteBits(unsigned char* block, unsigned position, unsigned count, unsigned value)
+	{
+		for (unsigned i = 0; i < count; ++i)
+		{
+			const unsigned bit = position + i;
+			block[bit / 8] = (unsigned char)((block[bit / 8] & ~(1 << (bit % 8))) | (((value >> i) & 1) << (bit % 8)));
+		}
+	}
+
+	// Every index must pick the palette entry closest to its texel, checked by decoding each alternative.
+	// Endpoints written without their indices (or the other way round) fail this
+	bool HasBestIndices(const unsigned char* block, const unsigned char* encoded)
+	{
+		const bool     mode6    = (encoded[0] & 0x7F) == 0x40;
+		const unsigned first    = mode6 ? 65 : 66; // Bit of the first color index
+		const unsigned bits     = mode6 ? 4 : 2;
+		const int      channels = mode6 ? 4 : 3;   // Mode 5 alpha has indices of its own
+
+		unsigned char decoded[64];
+		DecodeBC7Block(encoded, decoded);
+
+		for (unsigned i = 0; i < 16; ++i)
+		{
+			// The first index is stored without its top bit
+			const unsigned position = i == 0 ? first : first + bits - 1 + (i - 1) * bits;
+			const unsigned width    = i == 0 ? bits - 1 : bits;
+
+			auto error = [&](const unsigned char* pixels)
+			{
+				int sum = 0;
+				for (int c = 0; c < channels; ++c)
+					sum += (pixels[i * 4 + c] - block[i * 4 + c]) * (pixels[i * 4 + c] - block[i * 4 + c]);
+				return sum;
+			};
+
+			const int chosen = error(decoded);
+
+			for (unsigned index = 0; index < (1u << width); ++index)
+			{
+				unsigned char alternative[16], alternative_decoded[64];
+				std::copy(encoded, encoded + 16, alternative);
+				WriteBits(alternative, position, width, index);
+				DecodeBC7Block(alternative, alternative_decoded);
+
+				if (error(alternative_decoded) < chosen)
+					return false;
+			}
+		}
+		return true;
+	}
+
+	void TestBC1()
+	{
+		// 5:6:5 endpoints, a solid color is off by at most half a step of the coarsest channel plus rounding
+		const BlockError solid = RoundTrip(BlockFormat::BC1, 1000, 3, [](unsigned char* block) { SolidBlock(block, true); });
+		Check(solid.max <= 4, "BC1 solid colors within 4 per channel, got " + std::to_string(solid.max));
+
+		const BlockError gradient = RoundTrip(BlockFormat::BC1, 1000, 3, [](unsigned char* block) { GradientBlock(block, true); });
+		Check(gradient.total / (1000 * 48) < 110.0, "BC1 gradient mean squared error below 110, got " + std::to_string(gradient.total / (1000 * 48)));
+
+		// Transparent texels use the third palette entry, which decodes to alpha 0
+		unsigned char block[64], encoded[8], decoded[64];
+		SolidBlock(block, true);
+		block[3] = block[23] = 0;
+		EncodeBC1Block(block, encoded);
+		DecodeBC1Block(encoded, decoded);
+		Check(decoded[3] == 0 && decoded[23] == 0 && decoded[7] == 255, "BC1 keeps 1 bit alpha");
+	}
+
+	void TestBC7()
+	{
+		// 7 bit endpoints plus a p-bit in mode 6, solid colors are nearly exact
+		const BlockError solid = RoundTrip(BlockFormat::BC7, 1000, 4, [](unsigned char* block) { SolidBlock(block, false); });
+		Check(solid.max <= 2, "BC7 solid colors within 2 per channel, got " + std::to_string(solid.max));
+
+		const BlockError gradient = RoundTrip(BlockFormat::BC7, 1000, 4, [](unsigned char* block) { GradientBlock(block, false); });
+		Check(gradient.total / (1000 * 64) < 2.0, "BC7 gradient mean squared error below 2, got " + std::to_string(gradient.total / (1000 * 64)));
+
+		// Noise is the worst case for a single line fit, the bounds are a few percent above what the encoder reaches
+		const BlockError opaque = RoundTrip(BlockFormat::BC7, 20000, 3, [](unsigned char* block) { NoiseBlock(block, true); });
+		Check(opaque.total / (20000 * 48) < 2700.0, "BC7 opaque noise mean squared error below 2700, got " + std::to_string(opaque.total / (20000 * 48)));
+
+		const BlockError translucent = RoundTrip(BlockFormat::BC7, 5000, 4, [](unsigned char* block) { NoiseBlock(block, false); });
+		Check(translucent.total / (5000 * 64) < 2300.0, "BC7 translucent noise mean squared error below 2300, got " + std::to_string(translucent.total / (5000 * 64)));
+
+		int worse_indices = 0;
+		for (int b = 0; b < 20000; ++b)
+		{
+			unsigned char block[64], encoded[16];
+			NoiseBlock(block, b % 2 == 0);
+			// Transparent texels are encoded with a different color
+			for (int i = 3; i < 64; i += 4)
+				block[i] = std::max<unsigned char>(block[i], 1);
+			EncodeBC7Block(block, encoded);
+			worse_indices += !HasBestIndices(block, encoded);
+		}
+		Check(worse_indices == 0, "BC7 indices match their endpoints, " + std::to_string(worse_indices) + " blocks differ");
+
+		// Cut-out sprites: texels meant to be invisible must stay so
+		unsigned char block[64], encoded[16], decoded[64];
+		GradientBlock(block, true);
+		for (int i = 0; i < 16; ++i)
+			block[i * 4 + 3] = i % 3 == 0 ? 0 : 255;
+
+		EncodeBC7Block(block, encoded);
+		DecodeBC7Block(encoded, decoded);
+
+		bool alpha_exact = true;
+		for (int i = 0; i < 16; ++i)
+			alpha_exact = alpha_exact && decoded[i * 4 + 3] == block[i * 4 + 3];
+		Check(alpha_exact, "BC7 keeps binary alpha exact");
+	}
+
+	void TestImageRoundTrip()
+	{
+		// Sizes not divisible by 4 pad the edge blocks, decoding must crop them again
+		const unsigned width = 13, height = 7;
+		std::vector<unsigned char> pixels(width * height * 4);
+
+		for (auto& value : pixels)
+			value = (unsigned char)Random(256);
+
+		for (BlockFormat format : { BlockFormat::RGBA8, BlockFormat::BC1, BlockFormat::BC7 })
+		{
+			const std::vector<unsigned char> blocks = CompressImage(pixels.data(), width, height, format);
+			Check(blocks.size() == GetImageSize(format, width, height), "compressed image size");
+
+			const std::vector<unsigned char> decoded = DecompressImage(blocks.data(), width, height, format);
+			Check(decoded.size() == pixels.size(), "decompressed image size");
+		}
+
+		Check(GetImageSize(BlockFormat::BC1, 13, 7) == 4 * 2 * 8,  "BC1 image size rounds up to whole blocks");
+		Check(GetImageSize(BlockFormat::BC7, 13, 7) == 4 * 2 * 16, "BC7 image size rounds up to whole blocks");
+	}
+
+	void TestKtx2(BlockFormat format, bool premultiplied)
+	{
+		const std::string name = std::string(format == BlockFormat::BC1 ? "BC1" : format == BlockFormat::BC7 ? "BC7" : "RGBA8") +
+		                         (premultiplied ? " premultiplied" : "");
+
+		// Three levels of 20 x 12, filled with their own level number
+		const unsigned width = 20, height = 12;
+		std::vector<std::vector<unsigned char>> levels;
+
+		for (unsigned level = 0; level < 3; ++level)
+			levels.emplace_back(GetImageSize(format, std::max(width >> level, 1u), std::max(height >> level, 1u)), (unsigned char)(level + 1));
+
+		const std::string path = (std::filesystem::temp_directory_path() / "TextureCodecTests.ktx2").string();
+		Check(SaveKtx2(path, format, width, height, levels, premultiplied), name + ": file written");
+
+		const std::vector<unsigned char> file = ReadFile(path);
+		std::filesystem::remove(path);
+
+		if (file.size() < 80 + 3 * 24)
+		{
+			Check(false, name + ": file has a header and a level index");
+			return;
+		}
+
+		// Header
+		const std::uint32_t vk_format = format == BlockFormat::BC1 ? 133 : format == BlockFormat::BC7 ? 145 : 37;
+		Check(file[0] == 0xAB && file[1] == 'K' && file[5] == '2' && file[11] == '\n', name + ": identifier");
+		Check(ReadU32(file, 12) == vk_format, name + ": vkFormat");
+		Check(ReadU32(file, 20) == width && ReadU32(file, 24) == height, name + ": size");
+		Check(ReadU32(file, 36) == 1 && ReadU32(file, 40) == 3 && ReadU32(file, 44) == 0, name + ": faces, levels, supercompression");
+
+		// Data format descriptor: the basic block right after the level index
+		const std::uint32_t dfd_offset = ReadU32(file, 48);
+		const std::uint32_t dfd_size   = ReadU32(file, 52);
+		const std::uint32_t samples    = format == BlockFormat::RGBA8 ? 4 : 1;
+
+		Check(dfd_offset == 80 + 3 * 24, name + ": descriptor follows the level index");
+		Check(dfd_size == 4 + 24 + 16 * samples && dfd_offset + dfd_size <= file.size(), name + ": descriptor size");
+
+		if (dfd_offset + dfd_size <= file.size() && dfd_size >= 28)
+		{
+			const std::uint32_t color_model = format == BlockFormat::BC1 ? 128 : format == BlockFormat::BC7 ? 134 : 1;
+			const std::uint32_t model_word  = ReadU32(file, dfd_offset + 12);
+
+			Check(ReadU32(file, dfd_offset) == dfd_size, name + ": descriptor total size");
+			Check((ReadU32(file, dfd_offset + 8) >> 16) == 24 + 16 * samples, name + ": descriptor block size");
+			Check((model_word & 0xFF) == color_model, name + ": color model");
+			Check(((model_word >> 24) & 1) == (premultiplied ? 1u : 0u), name + ": premultiplied flag in the descriptor");
+			Check((ReadU32(file, dfd_offset + 16) & 0xFF) == (format == BlockFormat::RGBA8 ? 0u : 3u), name + ": texel block width");
+			Check((ReadU32(file, dfd_offset + 20) & 0xFF) == (format == BlockFormat::BC1 ? 8u : format == BlockFormat::BC7 ? 16u : 4u), name + ": bytes per block");
+		}
+
+		// Level index: sizes match, data inside the file and aligned
+		for (std::size_t level = 0; level < 3; ++level)
+		{
+			const std::size_t   index  = 80 + level * 24;
+			const std::uint64_t offset = ReadU32(file, index) | (std::uint64_t(ReadU32(file, index + 4)) << 32);
+			const std::uint64_t size   = ReadU32(file, index + 8);
+
+			Check(size == levels[level].size() && offset + size <= file.size() && offset % 16 == 0, name + ": level index entry " + std::to_string(level));
+		}
+
+		// Parsing gives everything back
+		Ktx2Image image;
+		Check(ParseKtx2(file, image), name + ": file parses");
+		Check(image.format == format && image.width == width && image.height == height, name + ": parsed format and size");
+		Check(image.premultiplied == premultiplied, name + ": parsed premultiplied flag");
+		Check(image.levels.size() == 3, name + ": parsed level count");
+
+		for (std::size_t level = 0; level < image.levels.size() && level < 3; ++level)
+		{
+			const unsigned char* data = image.getLevelData(level);
+			Check(image.levels[level].size == levels[level].size() && std::equal(data, data + image.levels[level].size, levels[level].begin()),
+			      name + ": parsed level data " + std::to_string(level));
+		}
+
+		// Broken files are rejected instead of read past the end
+		std::vector<unsigned char> truncated(file.begin(), file.end() - 1);
+		Check(!ParseKtx2(truncated, image), name + ": truncated file rejected");
+
+		std::vector<unsigned char> bad_identifier = file;
+		bad_identifier[1] = 'X';
+		Check(!ParseKtx2(bad_identifier, image), name + ": wrong identifier rejected");
+	}
+}
+
+int main()
+{
+	TestBC1();
+	TestBC7();
+	TestImageRoundTrip();
+
+	for (BlockFormat format : { BlockFormat::RGBA8, BlockFormat::BC1, BlockFormat::BC7 })
+		for (bool premultiplied : { false, true })
+			TestKtx2(format, premultiplied);
+
+	if (failures)
+	{
+		std::cout << failures << " checks failed\n";
+		return 1;
+	}
+
+	std::cout << "All checks passed\n";
+	return 0;
+}
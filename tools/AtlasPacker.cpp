@@ -0,0 +1,38 @@
+#include "TextureAtlas.hpp"
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+
+// Offline atlas bake: AtlasPacker <output path> <page size> <image> [image ...]
+// Every image is registered under its file name without directory and extension.
+int main(int argc, char* argv[])
+{
+	if (argc < 4)
+	{
+		std::cout << "Usage: AtlasPacker <output path> <page size> <image> [image ...]\n";
+		return -1;
+	}
+
+	const unsigned page_size = std::atoi(argv[2]);
+	TextureAtlas atlas(page_size, page_size);
+
+	for (int i = 3; i < argc; ++i)
+	{
+		std::string path = argv[i];
+		std::string name = path.substr(path.find_last_of("/\\") + 1);
+		name = name.substr(0, name.find_last_of('.'));
+
+		if (!atlas.addImage(name, path))
+			return -1;
+	}
+
+	if (!atlas.pack() || !atlas.saveToFile(argv[1]))
+	{
+		std::cout << "Failed to bake atlas " << argv[1] << '\n';
+		return -1;
+	}
+
+	std::cout << "Packed " << argc - 3 << " images into " << atlas.getPageCount() << " page(s)\n";
+	return 0;
+}
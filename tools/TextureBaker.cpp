@@ -0,0 +1,127 @@
+#include "BlockCompression.hpp"
+#include "Ktx2.hpp"
+#include "ImageOperations.hpp"
+
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Halves an RGBA image with a box filter, odd edges repeat the last texel
+std::vector<unsigned char> Downsample(const std::vector<unsigned char>& pixels, unsigned width, unsigned height)
+{
+	const unsigned next_width  = std::max(width / 2, 1u);
+	const unsigned next_height = std::max(height / 2, 1u);
+
+	std::vector<unsigned char> result(std::size_t(next_width) * next_height * 4);
+
+	for (unsigned y = 0; y < next_height; ++y)
+		for (unsigned x = 0; x < next_width; ++x)
+			for (unsigned c = 0; c < 4; ++c)
+			{
+				unsigned sum = 0;
+
+				for (unsigned dy = 0; dy < 2; ++dy)
+					for (unsigned dx = 0; dx < 2; ++dx)
+					{
+						unsigned source_x = std::min(x * 2 + dx, width - 1);
+						unsigned source_y = std::min(y * 2 + dy, height - 1);
+						sum += pixels[(std::size_t(source_y) * width + source_x) * 4 + c];
+					}
+
+				result[(std::size_t(y) * next_width + x) * 4 + c] = static_cast<unsigned char>((sum + 2) / 4);
+			}
+
+	return result;
+}
+
+// Offline texture bake: TextureBaker <input image> <output.ktx2> [bc7|bc1|rgba8] [--mips] [--premultiply] [--extrude <tile width>x<tile height>:<border>]
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		std::cout << "Usage: TextureBaker <input image> <output.ktx2> [bc7|bc1|rgba8] [--mips] [--premultiply] [--extrude <tile width>x<tile height>:<border>]\n";
+		return -1;
+	}
+
+	BlockFormat format = BlockFormat::BC7;
+	bool with_mips = false;
+	bool premultiply = false;
+	TileLayout tile_layout;
+
+	for (int i = 3; i < argc; ++i)
+	{
+		std::string option = argv[i];
+
+		if      (option == "bc7")    format = BlockFormat::BC7;
+		else if (option == "bc1")    format = BlockFormat::BC1;
+		else if (option == "rgba8")  format = BlockFormat::RGBA8;
+		else if (option == "--mips") with_mips = true;
+		else if (option == "--premultiply") premultiply = true;
+		else if (option == "--extrude" && i + 1 < argc)
+		{
+			const int read = std::sscanf(argv[++i], "%dx%d:%d", &tile_layout.tile_width, &tile_layout.tile_height, &tile_layout.border);
+
+			if (read != 3 || tile_layout.tile_width <= 0 || tile_layout.tile_height <= 0 || tile_layout.border < 0)
+			{
+				std::cout << "Bad tile layout " << argv[i] << '\n';
+				return -1;
+			}
+		}
+		else
+		{
+			std::cout << "Unknown option " << option << '\n';
+			return -1;
+		}
+	}
+
+	int width, height, channels;
+	unsigned char* data = stbi_load(argv[1], &width, &height, &channels, 4);
+
+	if (!data)
+	{
+		std::cout << "Failed to load " << argv[1] << '\n';
+		return -1;
+	}
+
+	// Extruded tiles go to the KTX2 as they are, load the tileset with the same border in TileMap::load
+	std::vector<unsigned char> pixels = ExtrudeTiles(data, width, height, 4, tile_layout);
+	GetExtrudedSize(width, height, tile_layout, width, height);
+	stbi_image_free(data);
+
+	// Before the mips, so transparent texels don't bleed their color into the smaller levels
+	if (premultiply)
+		PremultiplyAlpha(pixels.data(), pixels.size() / 4);
+
+	std::vector<std::vector<unsigned char>> levels;
+	unsigned level_width = width, level_height = height;
+
+	// Smaller levels than the border protects would blend neighbouring tiles
+	const std::size_t level_limit = tile_layout.border > 0 ? GetProtectedLevelCount(tile_layout) : 32;
+
+	while (true)
+	{
+		levels.push_back(CompressImage(pixels.data(), level_width, level_height, format));
+
+		if (!with_mips || (level_width == 1 && level_height == 1) || levels.size() == level_limit)
+			break;
+
+		pixels       = Downsample(pixels, level_width, level_height);
+		level_width  = std::max(level_width / 2, 1u);
+		level_height = std::max(level_height / 2, 1u);
+	}
+
+	if (!SaveKtx2(argv[2], format, width, height, levels, premultiply))
+		return -1;
+
+	std::size_t bytes = 0;
+	for (const auto& level : levels)
+		bytes += level.size();
+
+	std::cout << argv[1] << ": " << width << 'x' << height << ", " << levels.size() << " level(s), "
+	          << std::size_t(width) * height * 4 << " -> " << bytes << " bytes\n";
+	return 0;
+}